@@ -149,7 +149,7 @@ class Host {
 
 class Network {
   private:
-    Router _router{};
+    Router _router;
 
     size_t default_id, eth0_id, eth1_id, eth2_id, uun3_id, hs4_id, mit5_id;
 
@@ -205,21 +205,22 @@ class Network {
     }
 
   public:
-    Network()
-        : default_id(_router.add_interface({random_router_ethernet_address(), {"171.67.76.46"}}))
+    Network(const ForwardingTable::Kind forwarding_table, const size_t flow_cache_capacity)
+        : _router(forwarding_table, flow_cache_capacity)
+        , default_id(_router.add_interface({random_router_ethernet_address(), {"171.67.76.46"}}))
         , eth0_id(_router.add_interface({random_router_ethernet_address(), {"10.0.0.1"}}))
         , eth1_id(_router.add_interface({random_router_ethernet_address(), {"172.16.0.1"}}))
         , eth2_id(_router.add_interface({random_router_ethernet_address(), {"192.168.0.1"}}))
         , uun3_id(_router.add_interface({random_router_ethernet_address(), {"198.178.229.1"}}))
         , hs4_id(_router.add_interface({random_router_ethernet_address(), {"143.195.0.2"}}))
         , mit5_id(_router.add_interface({random_router_ethernet_address(), {"128.30.76.255"}})) {
-        _hosts.insert({"applesauce", {"applesauce", {"10.0.0.2"}, {"10.0.0.1"}}});
-        _hosts.insert({"default_router", {"default_router", {"171.67.76.1"}, {"0"}}});
+        _hosts.emplace("applesauce", Host{"applesauce", {"10.0.0.2"}, {"10.0.0.1"}});
+        _hosts.emplace("default_router", Host{"default_router", {"171.67.76.1"}, {"0"}});
         ;
-        _hosts.insert({"cherrypie", {"cherrypie", {"192.168.0.2"}, {"192.168.0.1"}}});
-        _hosts.insert({"hs_router", {"hs_router", {"143.195.0.1"}, {"0"}}});
-        _hosts.insert({"dm42", {"dm42", {"198.178.229.42"}, {"198.178.229.1"}}});
-        _hosts.insert({"dm43", {"dm43", {"198.178.229.43"}, {"198.178.229.1"}}});
+        _hosts.emplace("cherrypie", Host{"cherrypie", {"192.168.0.2"}, {"192.168.0.1"}});
+        _hosts.emplace("hs_router", Host{"hs_router", {"143.195.0.1"}, {"0"}});
+        _hosts.emplace("dm42", Host{"dm42", {"198.178.229.42"}, {"198.178.229.1"}});
+        _hosts.emplace("dm43", Host{"dm43", {"198.178.229.43"}, {"198.178.229.1"}});
 
         _router.add_route(ip("0.0.0.0"), 0, host("default_router").address(), default_id);
         _router.add_route(ip("10.0.0.0"), 8, {}, eth0_id);
@@ -269,12 +270,12 @@ class Network {
     }
 };
 
-void network_simulator() {
+void network_simulator(const ForwardingTable::Kind forwarding_table, const size_t flow_cache_capacity) {
     const string green = "\033[32;1m", normal = "\033[m";
 
     cerr << green << "Constructing network." << normal << "\n";
 
-    Network network;
+    Network network{forwarding_table, flow_cache_capacity};
 
     cout << green << "\n\nTesting traffic between two ordinary hosts (applesauce to cherrypie)..." << normal << "\n\n";
     {
@@ -345,7 +346,10 @@ void network_simulator() {
 
 int main() {
     try {
-        network_simulator();
+        // routed one datagram at a time, then in prefetched batches (by the table, and by the flow cache)
+        network_simulator(ForwardingTable::Kind::Trie, 0);
+        network_simulator(ForwardingTable::Kind::Dir24_8, 0);
+        network_simulator(ForwardingTable::Kind::Trie, 64);
     } catch (const exception &e) {
         cerr << "\n\n\n";
         cerr << "\033[31;1mError: " << e.what() << "\033[m\n";
@@ -0,0 +1,115 @@
+#include "forwarding_table.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t num_routes = 10000;
+constexpr size_t num_addresses = 1 << 20;
+constexpr size_t batch_size = 32;
+
+volatile uint64_t lookup_sink;  // keeps the lookups from being optimized away
+
+struct Route {
+    uint32_t prefix;
+    uint8_t prefix_length;
+};
+
+//! Mostly /24s, as in a full table, with some shorter and a few longer prefixes
+vector<Route> make_routes(mt19937 &rd) {
+    vector<Route> routes;
+    routes.push_back({0, 0});  // default route
+    while (routes.size() < num_routes) {
+        const unsigned int kind = rd() % 10;
+        uint8_t prefix_length = 24;
+        if (kind >= 6 and kind < 8) {
+            prefix_length = 16 + rd() % 8;
+        } else if (kind == 8) {
+            prefix_length = 8 + rd() % 8;
+        } else if (kind == 9) {
+            prefix_length = 25 + rd() % 8;
+        }
+        routes.push_back({static_cast<uint32_t>(rd()), prefix_length});
+    }
+    return routes;
+}
+
+//! Destinations inside the routes' prefixes
+vector<uint32_t> make_addresses(mt19937 &rd, const vector<Route> &routes) {
+    vector<uint32_t> addresses;
+    for (size_t i = 0; i < num_addresses; i++) {
+        const Route &route = routes[rd() % routes.size()];
+        const uint32_t mask = ForwardingTable::mask(route.prefix_length);
+        addresses.push_back((route.prefix & mask) | (static_cast<uint32_t>(rd()) & ~mask));
+    }
+    return addresses;
+}
+
+void benchmark(const string &name,
+               const ForwardingTable::Kind kind,
+               const vector<Route> &routes,
+               const vector<uint32_t> &addresses,
+               const size_t lookups) {
+    const auto build_start = high_resolution_clock::now();
+    const auto table = ForwardingTable::make(kind);
+    for (size_t i = 0; i < routes.size(); i++) {
+        table->insert(routes[i].prefix, routes[i].prefix_length, static_cast<uint32_t>(i));
+    }
+    const auto build_end = high_resolution_clock::now();
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < lookups; i++) {
+        sum += table->lookup(addresses[i % addresses.size()]);
+    }
+    const auto lookup_end = high_resolution_clock::now();
+
+    // the same lookups in batches, prefetching each batch first (as Router::route does, if the table prefetches)
+    for (size_t batch = 0; table->prefetches() and batch < lookups; batch += batch_size) {
+        const size_t end = min(batch + batch_size, lookups);
+        for (size_t i = batch; i < end; i++) {
+            table->prefetch(addresses[i % addresses.size()]);
+        }
+        for (size_t i = batch; i < end; i++) {
+            sum += table->lookup(addresses[i % addresses.size()]);
+        }
+    }
+    const auto batched_end = high_resolution_clock::now();
+    lookup_sink = sum;
+
+    const auto build_ms = duration_cast<microseconds>(build_end - build_start).count() / 1000.0;
+    const auto lookup_ns = double(duration_cast<nanoseconds>(lookup_end - build_end).count());
+    const auto batched_ns = double(duration_cast<nanoseconds>(batched_end - lookup_end).count());
+
+    cout << fixed << setprecision(2);
+    cout << name << ": built in " << build_ms << " ms, " << lookups * 1000.0 / lookup_ns << " million lookups/s";
+    if (table->prefetches()) {
+        cout << ", " << lookups * 1000.0 / batched_ns << " batched with prefetching";
+    }
+    cout << "\n";
+}
+
+int main() {
+    try {
+        mt19937 rd{12345};
+        const auto routes = make_routes(rd);
+        const auto addresses = make_addresses(rd, routes);
+
+        cout << "Longest-prefix match over " << routes.size() << " routes\n";
+        benchmark("linear  ", ForwardingTable::Kind::Linear, routes, addresses, num_addresses / 64);
+        benchmark("trie    ", ForwardingTable::Kind::Trie, routes, addresses, num_addresses * 16);
+        benchmark("DIR-24-8", ForwardingTable::Kind::Dir24_8, routes, addresses, num_addresses * 16);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
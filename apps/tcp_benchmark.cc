@@ -1,5 +1,6 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <iomanip>
@@ -17,14 +18,9 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
         x.segments_out().pop();
     }
     if (reorder) {
-        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
-            y.segment_received(move(*it));
-        }
-    } else {
-        for (auto it = segments.begin(); it != segments.end(); ++it) {
-            y.segment_received(move(*it));
-        }
+        reverse(segments.begin(), segments.end());
     }
+    y.segments_received(segments);
     segments.clear();
 }
 
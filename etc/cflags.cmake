@@ -18,3 +18,9 @@ endif ()
 set (CMAKE_CXX_FLAGS_DEBUG "${CMAKE_CXX_FLAGS_DEBUG} -ggdb3 -Og")
 set (CMAKE_CXX_FLAGS_DEBUGASAN "${CMAKE_CXX_FLAGS_DEBUG} -fsanitize=undefined -fsanitize=address")
 set (CMAKE_CXX_FLAGS_RELASAN "${CMAKE_CXX_FLAGS_RELEASE} -fsanitize=undefined -fsanitize=address")
+
+# Buffers count references non-atomically unless made thread-safe; this makes all of them thread-safe
+option (SPONGE_ATOMIC_BUFFERS "Count references to every Buffer atomically" OFF)
+if (SPONGE_ATOMIC_BUFFERS)
+    add_definitions (-DSPONGE_ATOMIC_BUFFERS)
+endif ()
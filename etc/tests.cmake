@@ -57,6 +57,23 @@ add_test(NAME t_retx_win             COMMAND fsm_retx_win)
 add_test(NAME t_loopback             COMMAND fsm_loopback)
 add_test(NAME t_loopback_win         COMMAND fsm_loopback_win)
 add_test(NAME t_reorder              COMMAND fsm_reorder)
+add_test(NAME t_listener             COMMAND tcp_listener)
+add_test(NAME t_timer_wheel          COMMAND timer_wheel)
+add_test(NAME t_fastopen             COMMAND tcp_fast_open)
+add_test(NAME t_batch_ack            COMMAND tcp_batch_ack)
+add_test(NAME t_buffer_pool          COMMAND buffer_pool)
+add_test(NAME t_buffer_list          COMMAND buffer_list)
+add_test(NAME t_buffer_refcount      COMMAND buffer_refcount)
+add_test(NAME t_header_views         COMMAND header_views)
+add_test(NAME t_header_serialize     COMMAND header_serialize)
+add_test(NAME t_checksum             COMMAND checksum)
+add_test(NAME t_tcp_offload          COMMAND tcp_offload)
+add_test(NAME t_forwarding_table     COMMAND forwarding_table)
+add_test(NAME t_flow_cache           COMMAND flow_cache)
+add_test(NAME t_spsc_ring            COMMAND spsc_ring)
+add_test(NAME t_router_parallel      COMMAND router_parallel)
+add_test(NAME t_routing_table        COMMAND routing_table)
+add_test(NAME t_rcu                  COMMAND rcu)
 
 add_test(NAME t_address_dt           COMMAND address_dt)
 add_test(NAME t_parser_dt            COMMAND parser_dt)
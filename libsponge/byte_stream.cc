@@ -33,6 +33,9 @@ string ByteStream::peek_output(const size_t len) const {
     return ret;
 }
 
+//! \param[in] len bytes will be viewed from the output side of the buffer
+string_view ByteStream::peek_view(const size_t len) const { return string_view(_buffer).substr(0, len); }
+
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
     _read_count += min(len, _buffer.size());
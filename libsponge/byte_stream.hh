@@ -3,6 +3,7 @@
 
 #include <queue>
 #include <string>
+#include <string_view>
 
 //! \brief An in-order byte stream.
 
@@ -54,6 +55,10 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream, without copying them
+    //! \returns a view that is valid until the stream is next modified
+    std::string_view peek_view(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -0,0 +1,44 @@
+#include "flow_cache.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+FlowCache::FlowCache(const size_t capacity) : _sets(), _set_bits(0) {
+    while ((size_t{1} << _set_bits) * WAYS < capacity and _set_bits < 32) {
+        _set_bits++;
+    }
+    _sets.resize(size_t{1} << _set_bits);
+}
+
+optional<uint32_t> FlowCache::find(const uint32_t address) {
+    Set &set = _set(address);
+    for (size_t way = 0; way < set.size; way++) {
+        if (set.addresses[way] == address) {
+            // move the entry to the front
+            const uint32_t route = set.routes[way];
+            rotate(set.addresses.begin(), set.addresses.begin() + way, set.addresses.begin() + way + 1);
+            rotate(set.routes.begin(), set.routes.begin() + way, set.routes.begin() + way + 1);
+            _hits++;
+            return route;
+        }
+    }
+    _misses++;
+    return nullopt;
+}
+
+void FlowCache::insert(const uint32_t address, const uint32_t route) {
+    Set &set = _set(address);
+    // shift the entries back, dropping the last one if the set is full
+    set.size = min(set.size + 1, WAYS);
+    copy_backward(set.addresses.begin(), set.addresses.begin() + set.size - 1, set.addresses.begin() + set.size);
+    copy_backward(set.routes.begin(), set.routes.begin() + set.size - 1, set.routes.begin() + set.size);
+    set.addresses[0] = address;
+    set.routes[0] = route;
+}
+
+void FlowCache::clear() {
+    for (auto &set : _sets) {
+        set.size = 0;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef SPONGE_LIBSPONGE_FLOW_CACHE_HH
+#define SPONGE_LIBSPONGE_FLOW_CACHE_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! \brief A fixed-size, set-associative cache of forwarding decisions, by destination address
+
+//! Sits in front of a ForwardingTable: a destination that was looked up recently maps straight
+//! to its route (which may be ForwardingTable::NO_ROUTE), without a longest-prefix match. Each
+//! destination hashes to one set of WAYS entries, kept in most-recently-used order; a new entry
+//! replaces the least recently used one of its set. Any change to the routes must clear() the cache.
+class FlowCache {
+  public:
+    //! Entries per set
+    static constexpr size_t WAYS = 4;
+
+  private:
+    struct Set {
+        std::array<uint32_t, WAYS> addresses{};
+        std::array<uint32_t, WAYS> routes{};
+        size_t size{0};  //!< number of valid entries, which are the first ones
+    };
+
+    std::vector<Set> _sets;
+    unsigned _set_bits;  //!< log2 of the number of sets
+    size_t _hits{0};
+    size_t _misses{0};
+
+    size_t _set_index(const uint32_t address) const {
+        // Fibonacci hashing spreads out neighboring addresses
+        return _set_bits == 0 ? 0 : (address * 2654435769u) >> (32 - _set_bits);
+    }
+
+    Set &_set(const uint32_t address) { return _sets[_set_index(address)]; }
+
+  public:
+    //! \param[in] capacity the number of entries, rounded up to a power-of-two number of sets
+    explicit FlowCache(const size_t capacity);
+
+    //! \brief The cached route for `address`, if any
+    std::optional<uint32_t> find(const uint32_t address);
+
+    //! \brief Cache `route` for `address`, which must not already be cached
+    void insert(const uint32_t address, const uint32_t route);
+
+    //! \brief Start loading the set that find() for `address` will read
+    void prefetch(const uint32_t address) const { __builtin_prefetch(&_sets[_set_index(address)]); }
+
+    //! \brief Forget every entry (but not the counters)
+    void clear();
+
+    //! \name Statistics
+    //!@{
+    size_t capacity() const { return _sets.size() * WAYS; }
+    size_t hits() const { return _hits; }      //!< number of calls to find() that found an entry
+    size_t misses() const { return _misses; }  //!< number of calls to find() that did not
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_FLOW_CACHE_HH
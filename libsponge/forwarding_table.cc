@@ -0,0 +1,163 @@
+#include "forwarding_table.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void check_prefix_length(const uint8_t prefix_length) {
+    if (prefix_length > 32) {
+        throw runtime_error("ForwardingTable: prefix length " + to_string(prefix_length) + " is longer than 32 bits");
+    }
+}
+
+unique_ptr<ForwardingTable> ForwardingTable::make(const Kind kind) {
+    switch (kind) {
+        case Kind::Linear:
+            return make_unique<LinearForwardingTable>();
+        case Kind::Trie:
+            return make_unique<TrieForwardingTable>();
+        case Kind::Dir24_8:
+            return make_unique<Dir24_8ForwardingTable>();
+    }
+    throw runtime_error("ForwardingTable: unknown kind");
+}
+
+void LinearForwardingTable::insert(const uint32_t prefix, const uint8_t prefix_length, const uint32_t route) {
+    check_prefix_length(prefix_length);
+    _entries.push_back({prefix & mask(prefix_length), prefix_length, route});
+}
+
+uint32_t LinearForwardingTable::lookup(const uint32_t address) const {
+    const Entry *best = nullptr;
+    for (const auto &entry : _entries) {
+        if ((address & mask(entry.prefix_length)) == entry.prefix and
+            (best == nullptr or best->prefix_length < entry.prefix_length)) {
+            best = &entry;
+        }
+    }
+    return best == nullptr ? NO_ROUTE : best->route;
+}
+
+TrieForwardingTable::TrieForwardingTable() { _nodes.push_back({0, 0, NO_ROUTE, {NO_NODE, NO_NODE}}); }
+
+void TrieForwardingTable::insert(const uint32_t prefix, const uint8_t prefix_length, const uint32_t route) {
+    check_prefix_length(prefix_length);
+    const uint32_t key = prefix & mask(prefix_length);
+
+    // Invariant: `key` extends the prefix of the node at `index`.
+    uint32_t index = 0;
+    while (true) {
+        if (_nodes[index].prefix_length == prefix_length) {
+            if (_nodes[index].route == NO_ROUTE) {
+                _nodes[index].route = route;
+            }
+            return;
+        }
+
+        const unsigned bit = _next_bit(key, _nodes[index].prefix_length);
+        const uint32_t child_index = _nodes[index].children[bit];
+        if (child_index == NO_NODE) {
+            _nodes[index].children[bit] = static_cast<uint32_t>(_nodes.size());
+            _nodes.push_back({key, prefix_length, route, {NO_NODE, NO_NODE}});
+            return;
+        }
+
+        // How much of the child's prefix does `key` share?
+        const Node child = _nodes[child_index];
+        const uint32_t difference = key ^ child.prefix;
+        const auto matching_bits = static_cast<uint8_t>(difference == 0 ? 32 : __builtin_clz(difference));
+        const uint8_t common_length = min({prefix_length, child.prefix_length, matching_bits});
+        if (common_length == child.prefix_length) {
+            index = child_index;
+            continue;
+        }
+
+        // Split the edge to the child with a node for the shared prefix, which may be the new route's own.
+        const uint32_t split_index = static_cast<uint32_t>(_nodes.size());
+        _nodes[index].children[bit] = split_index;
+        Node split{key & mask(common_length), common_length, NO_ROUTE, {NO_NODE, NO_NODE}};
+        split.children[_next_bit(child.prefix, common_length)] = child_index;
+        if (common_length == prefix_length) {
+            split.route = route;
+            _nodes.push_back(split);
+        } else {
+            split.children[_next_bit(key, common_length)] = split_index + 1;
+            _nodes.push_back(split);
+            _nodes.push_back({key, prefix_length, route, {NO_NODE, NO_NODE}});
+        }
+        return;
+    }
+}
+
+uint32_t TrieForwardingTable::lookup(const uint32_t address) const {
+    uint32_t best = NO_ROUTE;
+    uint32_t index = 0;
+    while (index != NO_NODE) {
+        const Node &node = _nodes[index];
+        if ((address & mask(node.prefix_length)) != node.prefix) {
+            break;
+        }
+        if (node.route != NO_ROUTE) {
+            best = node.route;
+        }
+        if (node.prefix_length == 32) {
+            break;
+        }
+        index = node.children[_next_bit(address, node.prefix_length)];
+    }
+    return best;
+}
+
+Dir24_8ForwardingTable::Dir24_8ForwardingTable() : _tbl24(size_t{1} << 24), _tbl24_lengths(size_t{1} << 24) {}
+
+void Dir24_8ForwardingTable::_write(uint32_t &entry,
+                                    uint8_t &entry_length,
+                                    const uint32_t route,
+                                    const uint8_t prefix_length) {
+    if (entry == 0 or entry_length < prefix_length) {
+        entry = route + 1;
+        entry_length = prefix_length;
+    }
+}
+
+void Dir24_8ForwardingTable::insert(const uint32_t prefix, const uint8_t prefix_length, const uint32_t route) {
+    check_prefix_length(prefix_length);
+    if (route >= BLOCK_FLAG - 1) {
+        throw runtime_error("Dir24_8ForwardingTable: route number too large");
+    }
+    const uint32_t key = prefix & mask(prefix_length);
+
+    if (prefix_length <= 24) {
+        // every /24 in the prefix, and every address of the /24s that have blocks
+        const size_t first = key >> 8;
+        const size_t last = first + (size_t{1} << (24 - prefix_length));
+        for (size_t i = first; i < last; i++) {
+            if (_tbl24[i] & BLOCK_FLAG) {
+                const size_t block = _tbl24[i] & ~BLOCK_FLAG;
+                for (size_t j = block << 8; j < (block + 1) << 8; j++) {
+                    _write(_tbl8[j], _tbl8_lengths[j], route, prefix_length);
+                }
+            } else {
+                _write(_tbl24[i], _tbl24_lengths[i], route, prefix_length);
+            }
+        }
+        return;
+    }
+
+    // a longer prefix covers part of one /24, which needs a block (starting out as the /24's route)
+    uint32_t &entry = _tbl24[key >> 8];
+    if (not(entry & BLOCK_FLAG)) {
+        const auto block = static_cast<uint32_t>(_tbl8.size() >> 8);  // below 2^24, one per /24 at most
+        _tbl8.resize(_tbl8.size() + 256, entry);
+        _tbl8_lengths.resize(_tbl8_lengths.size() + 256, _tbl24_lengths[key >> 8]);
+        entry = block | BLOCK_FLAG;
+    }
+    const size_t block = entry & ~BLOCK_FLAG;
+    const size_t first = (block << 8) | (key & 0xff);
+    const size_t last = first + (size_t{1} << (32 - prefix_length));
+    for (size_t j = first; j < last; j++) {
+        _write(_tbl8[j], _tbl8_lengths[j], route, prefix_length);
+    }
+}
@@ -0,0 +1,163 @@
+#ifndef SPONGE_LIBSPONGE_FORWARDING_TABLE_HH
+#define SPONGE_LIBSPONGE_FORWARDING_TABLE_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+//! \brief A longest-prefix-match table from IPv4 address prefixes to routes
+
+//! Routes are identified by a number (the Router uses the index of the route in its own list),
+//! so the table itself only has to find the longest prefix that matches an address. If the
+//! same prefix is inserted more than once, the first insertion wins.
+class ForwardingTable {
+  public:
+    //! Returned by lookup() when no prefix matches
+    static constexpr uint32_t NO_ROUTE = std::numeric_limits<uint32_t>::max();
+
+    //! The available implementations
+    enum class Kind {
+        Linear,  //!< LinearForwardingTable
+        Trie,    //!< TrieForwardingTable
+        Dir24_8  //!< Dir24_8ForwardingTable
+    };
+
+    //! \brief Construct an empty table of the given kind
+    static std::unique_ptr<ForwardingTable> make(const Kind kind);
+
+    //! \brief Add a route for the addresses whose top `prefix_length` bits match `prefix`'s
+    //! \note The bits of `prefix` beyond `prefix_length` are ignored.
+    virtual void insert(const uint32_t prefix, const uint8_t prefix_length, const uint32_t route) = 0;
+
+    //! \brief The route with the longest prefix that matches `address`, or NO_ROUTE
+    virtual uint32_t lookup(const uint32_t address) const = 0;
+
+    //! \brief Start loading the memory that a lookup of `address` will read first
+    //! \details Prefetching for a batch of addresses, then looking them up, overlaps their cache misses.
+    virtual void prefetch(const uint32_t address) const { static_cast<void>(address); }
+
+    //! \brief Whether prefetch() does anything (if not, there is nothing to gain by batching lookups)
+    virtual bool prefetches() const { return false; }
+
+    //! \brief A copy of the table, e.g. to change while this one is still being looked up in
+    virtual std::unique_ptr<ForwardingTable> clone() const = 0;
+
+    virtual ~ForwardingTable() = default;
+
+    //! The `prefix_length` high-order bits set
+    static uint32_t mask(const uint8_t prefix_length) {
+        return prefix_length == 0 ? 0 : ~uint32_t{0} << (32 - prefix_length);
+    }
+};
+
+//! \brief A forwarding table that compares the address with every prefix, in insertion order
+class LinearForwardingTable : public ForwardingTable {
+  private:
+    struct Entry {
+        uint32_t prefix;
+        uint8_t prefix_length;
+        uint32_t route;
+    };
+
+    std::vector<Entry> _entries{};
+
+  public:
+    void insert(const uint32_t prefix, const uint8_t prefix_length, const uint32_t route) override;
+    uint32_t lookup(const uint32_t address) const override;
+    std::unique_ptr<ForwardingTable> clone() const override { return std::make_unique<LinearForwardingTable>(*this); }
+};
+
+//! \brief A path-compressed binary trie
+
+//! Each node holds a prefix; a node's children extend its prefix by at least one more bit, chosen
+//! by the bit after the node's prefix. Nodes with a single child and no route are never created,
+//! so the trie has fewer than two nodes per route, and a lookup visits at most one node per bit
+//! of the longest matching prefix, whatever the number of routes. Nodes are kept in a vector and
+//! refer to each other by index, which keeps them close together in memory.
+class TrieForwardingTable : public ForwardingTable {
+  private:
+    static constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        uint32_t prefix;                   //!< the node's prefix, with the bits beyond `prefix_length` cleared
+        uint8_t prefix_length;             //!< number of significant bits in `prefix`
+        uint32_t route;                    //!< route for exactly this prefix, or NO_ROUTE
+        std::array<uint32_t, 2> children;  //!< indices of the children, by the next bit, or NO_NODE
+    };
+
+    //! The nodes; the root, at index 0, has the empty prefix
+    std::vector<Node> _nodes{};
+
+    //! The bit of `address` just past the first `prefix_length` bits
+    static unsigned _next_bit(const uint32_t address, const uint8_t prefix_length) {
+        return (address >> (31 - prefix_length)) & 1;
+    }
+
+  public:
+    //! \brief An empty trie, with just the root
+    TrieForwardingTable();
+
+    void insert(const uint32_t prefix, const uint8_t prefix_length, const uint32_t route) override;
+    uint32_t lookup(const uint32_t address) const override;
+    std::unique_ptr<ForwardingTable> clone() const override { return std::make_unique<TrieForwardingTable>(*this); }
+
+    //! \brief Number of nodes in the trie (including the root)
+    size_t size() const { return _nodes.size(); }
+};
+
+//! \brief A DIR-24-8 table, which finds a route in one memory access, or two for prefixes longer than 24 bits
+
+//! The first level is an array indexed by the top 24 bits of the address. Each entry holds either
+//! the value a lookup returns (the route number, which the RoutingTable uses to find the route's
+//! paths) or, if some prefix longer than 24 bits covers part of that /24, the number of a block in
+//! the second level: an array of 256 entries indexed by the last 8 bits of the address. Every entry
+//! holds the route with the longest prefix covering all of its addresses, so inserting a route
+//! writes the entries it covers that do not already have a longer prefix; the prefix length of each
+//! entry's route is kept beside the entries, and only read while inserting. The first level takes
+//! 64 MiB, and its prefix lengths another 16 MiB, allocated when the table is constructed.
+class Dir24_8ForwardingTable : public ForwardingTable {
+  private:
+    //! An entry with this bit set refers to a second-level block; otherwise it holds a route plus one (or zero)
+    static constexpr uint32_t BLOCK_FLAG = 0x80000000;
+
+    //! Entries of the first level, one per /24
+    std::vector<uint32_t> _tbl24;
+
+    //! The prefix length of the route in each entry of `_tbl24` that is not a block
+    std::vector<uint8_t> _tbl24_lengths;
+
+    //! Blocks of the second level, each 256 entries long
+    std::vector<uint32_t> _tbl8{};
+
+    //! The prefix length of the route in each entry of `_tbl8`
+    std::vector<uint8_t> _tbl8_lengths{};
+
+    //! Store `route` in `entry` unless the entry already has a route at least as specific
+    static void _write(uint32_t &entry, uint8_t &entry_length, const uint32_t route, const uint8_t prefix_length);
+
+  public:
+    //! \brief An empty table
+    Dir24_8ForwardingTable();
+
+    //! \note Routes must be numbered below 2^31 - 1; otherwise, this throws.
+    void insert(const uint32_t prefix, const uint8_t prefix_length, const uint32_t route) override;
+
+    uint32_t lookup(const uint32_t address) const override {
+        uint32_t entry = _tbl24[address >> 8];
+        if (entry & BLOCK_FLAG) {
+            entry = _tbl8[size_t{entry & ~BLOCK_FLAG} << 8 | (address & 0xff)];
+        }
+        return entry == 0 ? NO_ROUTE : entry - 1;
+    }
+
+    void prefetch(const uint32_t address) const override { __builtin_prefetch(&_tbl24[address >> 8]); }
+
+    bool prefetches() const override { return true; }
+
+    std::unique_ptr<ForwardingTable> clone() const override { return std::make_unique<Dir24_8ForwardingTable>(*this); }
+};
+
+#endif  // SPONGE_LIBSPONGE_FORWARDING_TABLE_HH
@@ -20,56 +20,119 @@ using namespace std;
 
 //! \param[in] ethernet_address Ethernet (what ARP calls "hardware") address of the interface
 //! \param[in] ip_address IP (what ARP calls "protocol") address of the interface
-NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address, const Address &ip_address)
-    : _ethernet_address(ethernet_address), _ip_address(ip_address) {
+//! \param[in] max_pending_datagrams the most datagrams kept waiting for any one next hop's Ethernet address
+NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address,
+                                   const Address &ip_address,
+                                   const size_t max_pending_datagrams)
+    : _max_pending_datagrams(max_pending_datagrams), _ethernet_address(ethernet_address), _ip_address(ip_address) {
     cerr << "DEBUG: Network interface has Ethernet address " << to_string(_ethernet_address) << " and IP address "
          << ip_address.ip() << "\n";
 }
 
+void NetworkInterface::_send_arp_request(const uint32_t ip_address, const EthernetAddress &dst) {
+    ARPMessage arp_message;
+    arp_message.opcode = ARPMessage::OPCODE_REQUEST;
+    arp_message.sender_ethernet_address = _ethernet_address;
+    arp_message.sender_ip_address = _ip_address.ipv4_numeric();
+    arp_message.target_ethernet_address = {};
+    arp_message.target_ip_address = ip_address;
+
+    EthernetFrame frame;
+    frame.header() = {/* dst  */ dst,
+                      /* src  */ _ethernet_address,
+                      /* type */ EthernetHeader::TYPE_ARP};
+    frame.payload() = arp_message.serialize();
+    _frames_out.push(frame);
+}
+
 //! \param[in] dgram the IPv4 datagram to be sent
 //! \param[in] next_hop the IP address of the interface to send it to (typically a router or default gateway, but may also be another host if directly connected to the same network as the destination)
 //! (Note: the Address type can be converted to a uint32_t (raw 32-bit IP address) with the Address::ipv4_numeric() method.)
 void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Address &next_hop) {
+    send_datagram(InternetDatagram{dgram}, next_hop);
+}
+
+//! \param[in] dgram the IPv4 datagram to be sent
+//! \param[in] next_hop the IP address of the interface to send it to
+void NetworkInterface::send_datagram(InternetDatagram &&dgram, const Address &next_hop) {
     // convert IP address of next hop to raw 32-bit representation (used in ARP header)
     const uint32_t next_hop_ip = next_hop.ipv4_numeric();
 
-    EthernetFrame frame;
-
     // Search the Ethernet address in the ARP table.
     auto iter = _arp_table.find(next_hop_ip);
     // If the destination Ethernet address is already known, send it right away.
     if (iter != _arp_table.end()) {
-        frame.header() = {
-            iter->second.eth_address,
-            _ethernet_address,
-            EthernetHeader::TYPE_IPv4,
-        };
-        frame.payload() = dgram.serialize();
-        _frames_out.emplace(frame);
+        ARPEntry &neighbor = iter->second;
+        _send_frame(move(dgram), neighbor);
+
+        // If the entry is about to expire, ask the neighbor to confirm it, while still using it.
+        if (neighbor.stale and not neighbor.refreshing) {
+            _send_arp_request(next_hop_ip, neighbor.eth_address);
+            _timers.reschedule(neighbor.expiry, ARP_ENTRY_REFRESH_WINDOW);
+            neighbor.refreshing = true;
+        }
         return;
     }
 
     // If the destination Ethernet address is unknown,
     // broadcast an ARP request for the next hop’s Ethernet address,
     // and queue the IP datagram, so it can be sent after the ARP reply is received.
-    if (_waiting_arp_request_map.find(next_hop_ip) == _waiting_arp_request_map.end()) {
-        ARPMessage arp_message;
-        arp_message.opcode = ARPMessage::OPCODE_REQUEST;
-        arp_message.sender_ethernet_address = _ethernet_address;
-        arp_message.sender_ip_address = _ip_address.ipv4_numeric();
-        arp_message.target_ethernet_address = {};
-        arp_message.target_ip_address = next_hop_ip;
-        frame.header() = {
-            ETHERNET_BROADCAST,
-            _ethernet_address,
-            EthernetHeader::TYPE_ARP,
-        };
-        frame.payload() = arp_message.serialize();
-        _frames_out.emplace(frame);
-
-        _waiting_arp_request_map[next_hop_ip] = ARP_REQUEST_DEFAULT_TTL;
+    auto pending = _pending_neighbors.find(next_hop_ip);
+    if (pending == _pending_neighbors.end()) {
+        _send_arp_request(next_hop_ip);
+        pending = _pending_neighbors
+                      .emplace(next_hop_ip,
+                               PendingNeighbor{_timers.schedule(ARP_REQUEST_DEFAULT_TTL,
+                                                               {next_hop_ip, ARPTimer::Kind::Request})})
+                      .first;
     }
-    _waiting_datagrams.emplace_back(next_hop, dgram);
+
+    // Keep the most recent datagrams if the next hop's queue is full.
+    auto &datagrams = pending->second.datagrams;
+    if (_max_pending_datagrams == 0) {
+        _dropped_datagrams++;
+        return;
+    }
+    if (datagrams.size() == _max_pending_datagrams) {
+        datagrams.pop_front();
+        _dropped_datagrams++;
+    }
+    datagrams.push_back(move(dgram));
+}
+
+NetworkInterface::ARPEntry &NetworkInterface::_learn(const uint32_t ip_address, const EthernetAddress &eth_address) {
+    // The entry goes stale (but stays usable) shortly before it expires.
+    const auto stale_timer = [&] {
+        return _timers.schedule(ARP_ENTRY_DEFAULT_TTL - ARP_ENTRY_REFRESH_WINDOW,
+                                {ip_address, ARPTimer::Kind::EntryStale});
+    };
+    auto entry = _arp_table.find(ip_address);
+    if (entry == _arp_table.end()) {
+        const auto expiry = _timers.schedule(ARP_ENTRY_DEFAULT_TTL, {ip_address, ARPTimer::Kind::EntryExpiry});
+        entry = _arp_table.emplace(ip_address, ARPEntry{eth_address, expiry, stale_timer()}).first;
+    } else {
+        ARPEntry &existing = entry->second;
+        existing.eth_address = eth_address;
+        _timers.reschedule(existing.expiry, ARP_ENTRY_DEFAULT_TTL);
+        if (existing.stale) {
+            existing.staleness = stale_timer();
+        } else {
+            _timers.reschedule(existing.staleness, ARP_ENTRY_DEFAULT_TTL - ARP_ENTRY_REFRESH_WINDOW);
+        }
+        existing.stale = existing.refreshing = false;
+    }
+
+    ARPEntry &neighbor = entry->second;
+    neighbor.frame_header = {eth_address, _ethernet_address, EthernetHeader::TYPE_IPv4};
+    neighbor.frame_header.serialize(neighbor.serialized_frame_header.data());
+    return neighbor;
+}
+
+void NetworkInterface::_send_frame(InternetDatagram &&dgram, const ARPEntry &neighbor) {
+    EthernetFrame frame;
+    frame.set_header(neighbor.frame_header, neighbor.serialized_frame_header);
+    frame.payload() = move(dgram).serialize();
+    _frames_out.push(move(frame));
 }
 
 //! \param[in] frame the incoming Ethernet frame
@@ -119,50 +182,72 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
         }
 
         if (is_arp_request || is_arp_response) {
-            _arp_table[src_ip_address] = {src_eth_address, ARP_ENTRY_DEFAULT_TTL};
-            for (auto iter = _waiting_datagrams.begin(); iter != _waiting_datagrams.end();) {
-                if (iter->first.ipv4_numeric() == src_ip_address) {
-                    send_datagram(iter->second, iter->first);
-                    iter = _waiting_datagrams.erase(iter);
-                } else
-                    ++iter;
+            const ARPEntry &neighbor = _learn(src_ip_address, src_eth_address);
+            // Send the datagrams that were waiting for this address, in the order they were queued.
+            const auto pending = _pending_neighbors.find(src_ip_address);
+            if (pending != _pending_neighbors.end()) {
+                _timers.cancel(pending->second.retransmission);
+                for (auto &dgram : pending->second.datagrams) {
+                    _send_frame(move(dgram), neighbor);
+                }
+                _pending_neighbors.erase(pending);
             }
-            _waiting_arp_request_map.erase(src_ip_address);
         }
     }
     return nullopt;
 }
 
-//! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
-void NetworkInterface::tick(const size_t ms_since_last_tick) {
-    for (auto iter = _arp_table.begin(); iter != _arp_table.end(); /* nop */) {
-        if (iter->second.ttl <= ms_since_last_tick)
-            iter = _arp_table.erase(iter);
-        else {
-            iter->second.ttl -= ms_since_last_tick;
-            ++iter;
+//! \param[in] frame the incoming Ethernet frame, serialized
+optional<InternetDatagram> NetworkInterface::recv_serialized_frame(const Buffer &frame) {
+    const EthernetHeaderView header{frame};
+    if (not header.valid()) {
+        return nullopt;
+    }
+    const EthernetAddress dst = header.dst();
+    if (dst != _ethernet_address && dst != ETHERNET_BROADCAST) {
+        return nullopt;
+    }
+
+    if (header.type() == EthernetHeader::TYPE_ARP) {
+        // only requests for our address and replies to us teach the interface anything
+        const ARPMessageView arp{header.payload()};
+        if (not arp.valid()) {
+            return nullopt;
         }
+        const bool is_arp_request =
+            arp.opcode() == ARPMessage::OPCODE_REQUEST && arp.target_ip_address() == _ip_address.ipv4_numeric();
+        const bool is_arp_response =
+            arp.opcode() == ARPMessage::OPCODE_REPLY && arp.target_ethernet_address() == _ethernet_address;
+        if (!is_arp_request && !is_arp_response) {
+            return nullopt;
+        }
+    } else if (header.type() != EthernetHeader::TYPE_IPv4) {
+        return nullopt;
     }
-    for (auto iter = _waiting_arp_request_map.begin(); iter != _waiting_arp_request_map.end(); /* nop */) {
-        if (iter->second <= ms_since_last_tick) {
-            ARPMessage arp_message;
-            arp_message.opcode = ARPMessage::OPCODE_REQUEST;
-            arp_message.sender_ethernet_address = _ethernet_address;
-            arp_message.sender_ip_address = _ip_address.ipv4_numeric();
-            arp_message.target_ethernet_address = {};
-            arp_message.target_ip_address = iter->first;
-
-            EthernetFrame eth_frame;
-            eth_frame.header() = {/* dst  */ ETHERNET_BROADCAST,
-                                  /* src  */ _ethernet_address,
-                                  /* type */ EthernetHeader::TYPE_ARP};
-            eth_frame.payload() = arp_message.serialize();
-            _frames_out.push(eth_frame);
-
-            iter->second = ARP_REQUEST_DEFAULT_TTL;
-        } else {
-            iter->second -= ms_since_last_tick;
-            ++iter;
+
+    EthernetFrame parsed;
+    if (parsed.parse(frame) != ParseResult::NoError) {
+        return nullopt;
+    }
+    return recv_frame(parsed);
+}
+
+//! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
+//! \details Only the ARP entries and requests whose timers expire are visited.
+void NetworkInterface::tick(const size_t ms_since_last_tick) {
+    for (const ARPTimer &timer : _timers.advance(ms_since_last_tick)) {
+        switch (timer.kind) {
+            case ARPTimer::Kind::Request:
+                _send_arp_request(timer.ip_address);
+                _pending_neighbors.at(timer.ip_address).retransmission =
+                    _timers.schedule(ARP_REQUEST_DEFAULT_TTL, {timer.ip_address, ARPTimer::Kind::Request});
+                break;
+            case ARPTimer::Kind::EntryStale:
+                _arp_table.at(timer.ip_address).stale = true;
+                break;
+            case ARPTimer::Kind::EntryExpiry:
+                _arp_table.erase(timer.ip_address);
+                break;
         }
     }
 }
@@ -3,9 +3,11 @@
 
 #include "ethernet_frame.hh"
 #include "tcp_over_ip.hh"
+#include "timer_wheel.hh"
 #include "tun.hh"
 
-#include <list>
+#include <array>
+#include <deque>
 #include <optional>
 #include <queue>
 #include <unordered_map>
@@ -36,21 +38,57 @@ class NetworkInterface {
     static constexpr size_t ARP_ENTRY_DEFAULT_TTL = 30 * 1000;
     static constexpr size_t ARP_REQUEST_DEFAULT_TTL = 5 * 1000;
 
+    //! For this long before an ARP entry expires, sending through it also asks (by unicast) for a refresh,
+    //! and if it does, the entry lasts at least this long for the reply
+    static constexpr size_t ARP_ENTRY_REFRESH_WINDOW = 3 * 1000;
+
+    //! What an ARP timer is for: an entry of the ARP table or an outstanding request.
+    struct ARPTimer {
+        enum class Kind {
+            Request,      //!< retransmit an outstanding request
+            EntryStale,   //!< an entry enters its refresh window
+            EntryExpiry,  //!< an entry expires
+        };
+
+        uint32_t ip_address;
+        Kind kind;
+    };
+
+    //! Deadlines of ARP entries and outstanding requests.
+    TimerWheel<ARPTimer> _timers{};
+
     //! ARP entry in ARP table.
-    //! It includes Ethernet address and TTL.
+    //! It includes Ethernet address, the timers for its expiry and for going stale shortly before, and the
+    //! header of IPv4 frames to that address, serialized once when the address is learned. A stale entry
+    //! is still used; the first datagram sent through it also sends a refresh request.
     struct ARPEntry {
         EthernetAddress eth_address;
-        size_t ttl;
+        TimerWheel<ARPTimer>::Handle expiry;
+        TimerWheel<ARPTimer>::Handle staleness;  //!< valid until the entry goes stale
+        EthernetHeader frame_header{};
+        std::array<char, EthernetHeader::LENGTH> serialized_frame_header{};
+        bool stale{false};       //!< is the entry in its refresh window?
+        bool refreshing{false};  //!< has a refresh request been sent?
     };
 
     //! The ARP table of the interface.
     std::unordered_map<uint32_t, ARPEntry> _arp_table{};
 
-    //! The arp response that waiting reply.
-    std::unordered_map<uint32_t, size_t> _waiting_arp_request_map{};
+    //! A next hop whose Ethernet address is being requested.
+    //! It includes the timer for the request's retransmission and the datagrams waiting for the reply.
+    struct PendingNeighbor {
+        TimerWheel<ARPTimer>::Handle retransmission;
+        std::deque<InternetDatagram> datagrams{};
+    };
+
+    //! The next hops with an outstanding ARP request, by IP address.
+    std::unordered_map<uint32_t, PendingNeighbor> _pending_neighbors{};
+
+    //! Most datagrams kept waiting for any one next hop; beyond this, the oldest are dropped
+    size_t _max_pending_datagrams;
 
-    //! The datagrams that waiting to send.
-    std::list<std::pair<Address, InternetDatagram>> _waiting_datagrams{};
+    //! Number of datagrams dropped because their next hop's queue was full
+    size_t _dropped_datagrams{0};
 
     //! Ethernet (known as hardware, network-access-layer, or link-layer) address of the interface
     EthernetAddress _ethernet_address;
@@ -61,9 +99,25 @@ class NetworkInterface {
     //! outbound queue of Ethernet frames that the NetworkInterface wants sent
     std::queue<EthernetFrame> _frames_out{};
 
+    //! Send an ARP request for `ip_address` to `dst` (by default, broadcast it)
+    void _send_arp_request(const uint32_t ip_address, const EthernetAddress &dst = ETHERNET_BROADCAST);
+
+    //! Learn (or relearn) that `ip_address` is at `eth_address`
+    //! \returns the ARP table's entry for `ip_address`
+    ARPEntry &_learn(const uint32_t ip_address, const EthernetAddress &eth_address);
+
+    //! Encapsulate `dgram` in a frame to `neighbor` and queue it for sending
+    void _send_frame(InternetDatagram &&dgram, const ARPEntry &neighbor);
+
   public:
+    //! Default for the most datagrams kept waiting for one next hop's Ethernet address
+    static constexpr size_t DEFAULT_MAX_PENDING_DATAGRAMS = 64;
+
     //! \brief Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer) addresses
-    NetworkInterface(const EthernetAddress &ethernet_address, const Address &ip_address);
+    //! \param[in] max_pending_datagrams is the most datagrams kept waiting for any one next hop's Ethernet address
+    NetworkInterface(const EthernetAddress &ethernet_address,
+                     const Address &ip_address,
+                     const size_t max_pending_datagrams = DEFAULT_MAX_PENDING_DATAGRAMS);
 
     //! \brief Access queue of Ethernet frames awaiting transmission
     std::queue<EthernetFrame> &frames_out() { return _frames_out; }
@@ -74,6 +128,10 @@ class NetworkInterface {
     //! ("Sending" is accomplished by pushing the frame onto the frames_out queue.)
     void send_datagram(const InternetDatagram &dgram, const Address &next_hop);
 
+    //! \brief Sends an IPv4 datagram, moving its payload into the frame (or into the queue of
+    //! datagrams waiting for the next hop's Ethernet address)
+    void send_datagram(InternetDatagram &&dgram, const Address &next_hop);
+
     //! \brief Receives an Ethernet frame and responds appropriately.
 
     //! If type is IPv4, returns the datagram.
@@ -81,8 +139,17 @@ class NetworkInterface {
     //! If type is ARP reply, learn a mapping from the "sender" fields.
     std::optional<InternetDatagram> recv_frame(const EthernetFrame &frame);
 
+    //! \brief Receives a serialized Ethernet frame, as read from the network
+    //! \details Equivalent to parsing the frame and calling recv_frame(), except that frames for other
+    //! interfaces, of other types, and ARP messages that would be ignored are dropped by looking at the
+    //! raw headers, before anything is parsed.
+    std::optional<InternetDatagram> recv_serialized_frame(const Buffer &frame);
+
     //! \brief Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Number of datagrams dropped while waiting for a next hop's Ethernet address
+    size_t dropped_datagrams() const { return _dropped_datagrams; }
 };
 
 #endif  // SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
@@ -0,0 +1,155 @@
+#include "parallel_router.hh"
+
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+size_t ParallelRouter::add_interface(AsyncNetworkInterface &&interface) {
+    if (_running.load()) {
+        throw runtime_error("ParallelRouter: cannot add an interface while running");
+    }
+    _workers.push_back(make_unique<Worker>(move(interface)));
+    for (auto &worker : _workers) {
+        while (worker->handoffs.size() < _workers.size()) {
+            worker->handoffs.push_back(make_unique<SPSCRing<Handoff>>(RING_CAPACITY));
+        }
+    }
+    return _workers.size() - 1;
+}
+
+//! \param[in] route_prefix the address prefix to match destination addresses against
+//! \param[in] prefix_length how many high-order bits of `route_prefix` must match
+//! \param[in] next_hop the IP address of the next hop, or empty if the network is directly attached
+//! \param[in] interface_num the index of the interface to send matching datagrams out on
+//! \param[in] weight the path's share of the route's flows, if the route has several
+void ParallelRouter::add_route(const uint32_t route_prefix,
+                               const uint8_t prefix_length,
+                               const optional<Address> next_hop,
+                               const size_t interface_num,
+                               const uint32_t weight) {
+    _routing_table.update(
+        [&](RoutingTable &table) { table.add_route(route_prefix, prefix_length, next_hop, interface_num, weight); });
+}
+
+void ParallelRouter::start() {
+    if (_running.exchange(true)) {
+        return;
+    }
+    for (auto &worker : _workers) {
+        if (worker->reader == nullptr) {
+            worker->reader = &_routing_table.add_reader();  // from now on, route changes are made to copies
+        }
+    }
+    for (size_t i = 0; i < _workers.size(); i++) {
+        _workers[i]->thread = thread(&ParallelRouter::_run, this, i);
+    }
+}
+
+void ParallelRouter::stop() {
+    if (not _running.exchange(false)) {
+        return;
+    }
+    for (auto &worker : _workers) {
+        worker->thread.join();
+    }
+}
+
+bool ParallelRouter::push_frame(const size_t interface_num, EthernetFrame &&frame) {
+    // the worker releases the payload, so its reference counts must be atomic
+    frame.payload() = as_const(frame).payload().thread_safe();
+    return _workers.at(interface_num)->frames_in.push(move(frame));
+}
+
+optional<EthernetFrame> ParallelRouter::pop_frame(const size_t interface_num) {
+    return _workers.at(interface_num)->frames_out.pop();
+}
+
+size_t ParallelRouter::dropped_datagrams() const {
+    size_t ret = 0;
+    for (const auto &worker : _workers) {
+        ret += worker->dropped.load(memory_order_relaxed);
+    }
+    return ret;
+}
+
+void ParallelRouter::_route(const size_t index, const RoutingTable &table, InternetDatagram &&dgram) {
+    const uint32_t dst = as_const(dgram).header().dst;
+    const uint32_t route = table.lookup(dst);
+    if (route == ForwardingTable::NO_ROUTE or not dgram.decrement_ttl()) {
+        return;
+    }
+
+    const auto &path = RoutingTable::path(table.route(route), dgram);
+    const uint32_t next_hop = RoutingTable::next_hop(path, dst);
+    if (path.interface_num == index) {
+        _workers[index]->interface.send_datagram(move(dgram), Address::from_ipv4_numeric(next_hop));
+        return;
+    }
+
+    Worker &target = *_workers[path.interface_num];
+    dgram.payload() = as_const(dgram).payload().thread_safe();
+    if (not target.handoffs[index]->push({move(dgram), next_hop})) {
+        target.dropped.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+//! \param[in] index the worker's interface
+void ParallelRouter::_run(const size_t index) {
+    Worker &worker = *_workers[index];
+    auto &interface = worker.interface;
+    auto last_tick = chrono::steady_clock::now();
+
+    while (_running.load(memory_order_relaxed)) {
+        bool idle = true;
+
+        // frames from the owner
+        for (auto frame = worker.frames_in.pop(); frame.has_value(); frame = worker.frames_in.pop()) {
+            interface.recv_frame(frame.value());
+            idle = false;
+        }
+
+        // datagrams that arrived here, all routed with the latest routing table
+        auto &datagrams = interface.datagrams_out();
+        if (not datagrams.empty()) {
+            const auto table = _routing_table.read(*worker.reader);
+            while (not datagrams.empty()) {
+                _route(index, *table, move(datagrams.front()));
+                datagrams.pop();
+            }
+            idle = false;
+        }
+
+        // datagrams routed here by the other workers
+        for (auto &ring : worker.handoffs) {
+            for (auto handoff = ring->pop(); handoff.has_value(); handoff = ring->pop()) {
+                interface.send_datagram(move(handoff->dgram), Address::from_ipv4_numeric(handoff->next_hop));
+                idle = false;
+            }
+        }
+
+        // frames to the owner, as many as fit
+        auto &frames = interface.frames_out();
+        while (not frames.empty()) {
+            EthernetFrame &frame = frames.front();
+            frame.payload() = as_const(frame).payload().thread_safe();
+            if (not worker.frames_out.push(move(frame))) {
+                break;
+            }
+            frames.pop();
+            idle = false;
+        }
+
+        const auto now = chrono::steady_clock::now();
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - last_tick);
+        if (elapsed.count() > 0) {
+            interface.tick(elapsed.count());
+            last_tick += elapsed;
+        }
+
+        if (idle) {
+            this_thread::yield();
+        }
+    }
+}
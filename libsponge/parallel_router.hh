@@ -0,0 +1,110 @@
+#ifndef SPONGE_LIBSPONGE_PARALLEL_ROUTER_HH
+#define SPONGE_LIBSPONGE_PARALLEL_ROUTER_HH
+
+#include "rcu.hh"
+#include "router.hh"
+#include "routing_table.hh"
+#include "spsc_ring.hh"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+//! \brief A router that runs each of its network interfaces on a thread of its own
+
+//! Each worker thread owns one interface: it receives that interface's frames, routes the
+//! datagrams that arrive on it, and sends the datagrams routed out of it. A datagram that leaves
+//! by another interface is handed to that interface's worker through a bounded, lock-free ring
+//! (one per pair of workers, so each has a single producer and a single consumer). Routes can be
+//! changed while the workers run: the change is made to a copy of the routing table, which is then
+//! published for the workers to pick up, so lookups take no locks and never wait for a change.
+//! Until start() is first called, changes are made to the routing table itself.
+//!
+//! The owner (the thread that constructed the router) exchanges frames with the workers through
+//! a ring in each direction per interface; it must not touch the interfaces once start() is called.
+class ParallelRouter {
+  public:
+    //! Capacity of each ring
+    static constexpr size_t RING_CAPACITY = 1024;
+
+  private:
+    //! A routed datagram on its way to the worker of its outbound interface
+    struct Handoff {
+        InternetDatagram dgram{};
+        uint32_t next_hop{};
+    };
+
+    //! An interface and the thread that runs it
+    struct Worker {
+        AsyncNetworkInterface interface;
+        RCU<RoutingTable>::Reader *reader{nullptr};  //!< for reading `_routing_table`, registered by start()
+        SPSCRing<EthernetFrame> frames_in{RING_CAPACITY};   //!< from the owner
+        SPSCRing<EthernetFrame> frames_out{RING_CAPACITY};  //!< to the owner
+        std::vector<std::unique_ptr<SPSCRing<Handoff>>> handoffs{};  //!< from each worker, by index
+        std::atomic<size_t> dropped{0};  //!< datagrams dropped because this worker's ring was full
+        std::thread thread{};
+
+        explicit Worker(AsyncNetworkInterface &&iface) : interface(std::move(iface)) {}
+        Worker(const Worker &other) = delete;
+        Worker &operator=(const Worker &other) = delete;
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers{};
+    RCU<RoutingTable> _routing_table;
+    std::atomic<bool> _running{false};
+
+    //! The body of worker `index`'s thread
+    void _run(const size_t index);
+
+    //! Route a datagram that arrived at worker `index` by `table`
+    void _route(const size_t index, const RoutingTable &table, InternetDatagram &&dgram);
+
+  public:
+    //! \param[in] forwarding_table the kind of table to look up routes in
+    explicit ParallelRouter(const ForwardingTable::Kind forwarding_table = ForwardingTable::Kind::Trie)
+        : _routing_table(std::make_unique<RoutingTable>(forwarding_table)) {}
+
+    //! Stops the workers
+    ~ParallelRouter() { stop(); }
+
+    //! \name Not copyable or movable, since the workers refer to it
+    //!@{
+    ParallelRouter(const ParallelRouter &other) = delete;
+    ParallelRouter &operator=(const ParallelRouter &other) = delete;
+    //!@}
+
+    //! \brief Add an interface (only while the workers are stopped)
+    //! \returns The index of the interface
+    size_t add_interface(AsyncNetworkInterface &&interface);
+
+    //! \brief Add a route, or another path to a route (from any one thread at a time)
+    void add_route(const uint32_t route_prefix,
+                   const uint8_t prefix_length,
+                   const std::optional<Address> next_hop,
+                   const size_t interface_num,
+                   const uint32_t weight = 1);
+
+    //! \brief Make several changes to the routes, which take effect together (see Router::update_routes())
+    void update_routes(const std::function<void(RoutingTable &)> &change) { _routing_table.update(change); }
+
+    //! \brief Start one worker thread per interface
+    void start();
+
+    //! \brief Stop the worker threads and wait for them to finish
+    void stop();
+
+    //! \brief Give a frame to interface `interface_num` (owner only)
+    //! \returns `false`, leaving `frame` untouched, if the interface's ring is full
+    bool push_frame(const size_t interface_num, EthernetFrame &&frame);
+
+    //! \brief Take a frame that interface `interface_num` has sent (owner only)
+    std::optional<EthernetFrame> pop_frame(const size_t interface_num);
+
+    //! \brief Number of datagrams dropped because the ring to their outbound interface was full
+    size_t dropped_datagrams() const;
+};
+
+#endif  // SPONGE_LIBSPONGE_PARALLEL_ROUTER_HH
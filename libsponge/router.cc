@@ -1,6 +1,8 @@
 #include "router.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 using namespace std;
 
@@ -18,48 +20,133 @@ using namespace std;
 template <typename... Targs>
 void DUMMY_CODE(Targs &&... /* unused */) {}
 
+//! \param[in] forwarding_table the kind of table to look up routes in
+//! \param[in] flow_cache_capacity the number of destinations to cache routes for (zero disables the cache)
+Router::Router(const ForwardingTable::Kind forwarding_table, const size_t flow_cache_capacity)
+    : _routing_table(make_unique<RoutingTable>(forwarding_table)) {
+    if (flow_cache_capacity > 0) {
+        _flow_cache.emplace(flow_cache_capacity);
+    }
+}
+
 //! \param[in] route_prefix The "up-to-32-bit" IPv4 address prefix to match the datagram's destination address against
 //! \param[in] prefix_length For this route to be applicable, how many high-order (most-significant) bits of the route_prefix will need to match the corresponding bits of the datagram's destination address?
 //! \param[in] next_hop The IP address of the next hop. Will be empty if the network is directly attached to the router (in which case, the next hop address should be the datagram's final destination).
 //! \param[in] interface_num The index of the interface to send the datagram out on.
+//! \param[in] weight The share of the route's flows to send by this next hop, if the route has several
 void Router::add_route(const uint32_t route_prefix,
                        const uint8_t prefix_length,
                        const optional<Address> next_hop,
-                       const size_t interface_num) {
+                       const size_t interface_num,
+                       const uint32_t weight) {
     cerr << "DEBUG: adding route " << Address::from_ipv4_numeric(route_prefix).ip() << "/" << int(prefix_length)
          << " => " << (next_hop.has_value() ? next_hop->ip() : "(direct)") << " on interface " << interface_num << "\n";
 
-    _route_table.push_back({route_prefix, prefix_length, next_hop, interface_num});
+    _routing_table.update(
+        [&](RoutingTable &table) { table.add_route(route_prefix, prefix_length, next_hop, interface_num, weight); });
 }
 
-//! \param[in] dgram The datagram to be routed
-void Router::route_one_datagram(InternetDatagram &dgram) {
-    const uint32_t dst_ip_addr = dgram.header().dst;
-    auto max_matched_entry = _route_table.end();
+uint32_t Router::_lookup(const RoutingTable &table, const uint32_t address) {
+    if (not _flow_cache.has_value()) {
+        return table.lookup(address);
+    }
+    const auto cached = _flow_cache->find(address);
+    if (cached.has_value()) {
+        return cached.value();
+    }
+    const uint32_t route = table.lookup(address);
+    _flow_cache->insert(address, route);
+    return route;
+}
 
-    for (auto iter = _route_table.begin(); iter != _route_table.end(); iter++)
-        if (iter->prefix_length == 0 || (iter->route_prefix ^ dst_ip_addr) >> (32 - iter->prefix_length) == 0)
-            if (max_matched_entry == _route_table.end() || max_matched_entry->prefix_length < iter->prefix_length)
-                max_matched_entry = iter;
+//! \param[in] dgram The datagram to be routed
+//! \param[in] path The path it takes, or null if no route matched
+void Router::route_one_datagram(InternetDatagram &&dgram, const RoutingTable::Path *path) {
+    const uint32_t dst_ip_addr = as_const(dgram).header().dst;
 
-    if (max_matched_entry != _route_table.end() && dgram.header().ttl-- > 1) {
-        auto &interface = _interfaces[max_matched_entry->interface_num];
-        auto next_hop = max_matched_entry->next_hop;
+    if (path != nullptr && dgram.decrement_ttl()) {
+        auto &interface = _interfaces[path->interface_num];
+        const auto &next_hop = path->next_hop;
 
         if (next_hop.has_value())
-            interface.send_datagram(dgram, next_hop.value());
+            interface.send_datagram(move(dgram), next_hop.value());
         else
-            interface.send_datagram(dgram, Address::from_ipv4_numeric(dst_ip_addr));
+            interface.send_datagram(move(dgram), Address::from_ipv4_numeric(dst_ip_addr));
+    }
+}
+
+void Router::_route_batch(queue<InternetDatagram> &queue) {
+    // The whole batch is routed with the latest routing table; the guard keeps it (and the paths
+    // the batch points to) alive even if the routes change meanwhile.
+    const auto table = _routing_table.read(*_reader);
+    if (_flow_cache.has_value() and table->version() != _flow_cache_version) {
+        _flow_cache->clear();
+        _flow_cache_version = table->version();
+    }
+
+    // Without prefetching, batching would only add the cost of gathering and sorting the batch.
+    if (not _flow_cache.has_value() and not table->prefetches()) {
+        for (size_t i = 0; i < ROUTE_BATCH_SIZE and not queue.empty(); i++) {
+            InternetDatagram dgram = move(queue.front());
+            queue.pop();
+            const uint32_t route = table->lookup(as_const(dgram).header().dst);
+            const RoutingTable::Path *path = nullptr;
+            if (route != ForwardingTable::NO_ROUTE) {
+                path = &RoutingTable::path(table->route(route), dgram);
+            }
+            route_one_datagram(move(dgram), path);
+        }
+        return;
+    }
+
+    _batch.clear();
+    while (not queue.empty() and _batch.size() < ROUTE_BATCH_SIZE) {
+        _batch.push_back({move(queue.front()), nullptr});
+        queue.pop();
+    }
+
+    // Start all the lookups' first memory accesses before waiting on any of them.
+    for (const auto &routed : _batch) {
+        const uint32_t dst = routed.dgram.header().dst;
+        if (_flow_cache.has_value()) {
+            _flow_cache->prefetch(dst);
+        }
+        table->prefetch(dst);
+    }
+    for (auto &routed : _batch) {
+        const uint32_t route = _lookup(*table, as_const(routed.dgram).header().dst);
+        if (route != ForwardingTable::NO_ROUTE) {
+            routed.path = &RoutingTable::path(table->route(route), routed.dgram);
+        }
+    }
+
+    // Send to one interface at a time; datagrams for the same interface keep their order.
+    _batch_order.resize(_batch.size());
+    for (uint32_t i = 0; i < _batch_order.size(); i++) {
+        _batch_order[i] = i;
+    }
+    const auto interface_of = [&](const uint32_t i) {
+        const auto *path = _batch[i].path;
+        return path == nullptr ? _interfaces.size() : path->interface_num;
+    };
+    stable_sort(_batch_order.begin(), _batch_order.end(), [&](const uint32_t a, const uint32_t b) {
+        return interface_of(a) < interface_of(b);
+    });
+    for (const uint32_t i : _batch_order) {
+        route_one_datagram(move(_batch[i].dgram), _batch[i].path);
     }
 }
 
 void Router::route() {
+    if (_reader == nullptr) {
+        _reader = &_routing_table.add_reader();  // from now on, route changes are made to copies
+    }
+
     // Go through all the interfaces, and route every incoming datagram to its proper outgoing interface.
     for (auto &interface : _interfaces) {
         auto &queue = interface.datagrams_out();
         while (not queue.empty()) {
-            route_one_datagram(queue.front());
-            queue.pop();
+            _route_batch(queue);
         }
     }
 }
@@ -1,8 +1,12 @@
 #ifndef SPONGE_LIBSPONGE_ROUTER_HH
 #define SPONGE_LIBSPONGE_ROUTER_HH
 
+#include "flow_cache.hh"
 #include "network_interface.hh"
+#include "rcu.hh"
+#include "routing_table.hh"
 
+#include <functional>
 #include <optional>
 #include <queue>
 #include <vector>
@@ -19,7 +23,7 @@ class AsyncNetworkInterface : public NetworkInterface {
     using NetworkInterface::NetworkInterface;
 
     //! Construct from a NetworkInterface
-    AsyncNetworkInterface(NetworkInterface &&interface) : NetworkInterface(interface) {}
+    AsyncNetworkInterface(NetworkInterface &&interface) : NetworkInterface(std::move(interface)) {}
 
     //! \brief Receives and Ethernet frame and responds appropriately.
 
@@ -41,25 +45,67 @@ class AsyncNetworkInterface : public NetworkInterface {
 
 //! \brief A router that has multiple network interfaces and
 //! performs longest-prefix-match routing between them.
+
+//! The routes may be changed (by add_route() or update_routes()) from another thread while
+//! route() runs: changes are made to a copy of the routing table, which route() picks up for its
+//! next batch of datagrams, so routing never waits for them. Until route() first runs, changes
+//! are made to the routing table itself.
 class Router {
     //! The router's collection of network interfaces
     std::vector<AsyncNetworkInterface> _interfaces{};
 
-    struct route_table_entry {
-        const uint32_t route_prefix{};
-        const uint8_t prefix_length{};
-        const std::optional<Address> next_hop{};
-        const size_t interface_num{};
+    //! The routes
+    RCU<RoutingTable> _routing_table;
+
+    //! The reader of `_routing_table` used by route(), registered when it first runs
+    RCU<RoutingTable>::Reader *_reader{nullptr};
+
+    //! Recent results of `_routing_table` lookups, if enabled
+    std::optional<FlowCache> _flow_cache{};
+
+    //! The RoutingTable::version() the flow cache's entries were looked up in
+    uint64_t _flow_cache_version{0};
+
+    //! The route for `address` in `table`, from the flow cache if possible
+    uint32_t _lookup(const RoutingTable &table, const uint32_t address);
+
+    //! Most datagrams routed together by route()
+    static constexpr size_t ROUTE_BATCH_SIZE = 32;
+
+    //! A datagram being routed, and the path it takes (null if no route matched)
+    struct RoutedDatagram {
+        InternetDatagram dgram;
+        const RoutingTable::Path *path;
     };
 
-    std::vector<route_table_entry> _route_table{};
+    //! The batch of datagrams being routed (kept to reuse its storage)
+    std::vector<RoutedDatagram> _batch{};
+
+    //! The order in which to send the datagrams of `_batch`
+    std::vector<uint32_t> _batch_order{};
+
+    //! Route up to ROUTE_BATCH_SIZE datagrams from `queue` by one version of the routes. If the flow cache
+    //! or the forwarding table can prefetch, first prefetch the start of every lookup, then look them all
+    //! up, then send them, grouped by outbound interface; otherwise, route each datagram in turn.
+    void _route_batch(std::queue<InternetDatagram> &queue);
 
     //! Send a single datagram from the appropriate outbound interface to the next hop,
-    //! as specified by the route with the longest prefix_length that matches the
-    //! datagram's destination address.
-    void route_one_datagram(InternetDatagram &dgram);
+    //! as specified by `path` (the datagram's path by the route with the longest prefix_length
+    //! that matches its destination address, or null if there is no such route).
+    void route_one_datagram(InternetDatagram &&dgram, const RoutingTable::Path *path);
 
   public:
+    //! \param[in] forwarding_table the kind of table to look up routes in
+    //! \param[in] flow_cache_capacity the number of destinations to cache routes for (zero disables the cache)
+    explicit Router(const ForwardingTable::Kind forwarding_table = ForwardingTable::Kind::Trie,
+                    const size_t flow_cache_capacity = 0);
+
+    //! \name Not copyable or movable, since `_reader` belongs to `_routing_table`
+    //!@{
+    Router(const Router &other) = delete;
+    Router &operator=(const Router &other) = delete;
+    //!@}
+
     //! Add an interface to the router
     //! \param[in] interface an already-constructed network interface
     //! \returns The index of the interface after it has been added to the router
@@ -71,14 +117,22 @@ class Router {
     //! Access an interface by index
     AsyncNetworkInterface &interface(const size_t N) { return _interfaces.at(N); }
 
-    //! Add a route (a forwarding rule)
+    //! Add a route (a forwarding rule), or another equal-cost path to a route with the same prefix
     void add_route(const uint32_t route_prefix,
                    const uint8_t prefix_length,
                    const std::optional<Address> next_hop,
-                   const size_t interface_num);
+                   const size_t interface_num,
+                   const uint32_t weight = 1);
+
+    //! Make several changes to the routes, which take effect together
+    //! \param[in] change called with a copy of the routing table (or, before route() first runs, the table), to change
+    void update_routes(const std::function<void(RoutingTable &)> &change) { _routing_table.update(change); }
 
     //! Route packets between the interfaces
     void route();
+
+    //! The flow cache, if enabled, e.g. for its hit and miss counts
+    const std::optional<FlowCache> &flow_cache() const { return _flow_cache; }
 };
 
 #endif  // SPONGE_LIBSPONGE_ROUTER_HH
@@ -0,0 +1,126 @@
+#include "routing_table.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+RoutingTable::RoutingTable(const ForwardingTable::Kind forwarding_table)
+    : _forwarding_table(ForwardingTable::make(forwarding_table)) {}
+
+RoutingTable::RoutingTable(const RoutingTable &other)
+    : _routes(other._routes)
+    , _route_numbers(other._route_numbers)
+    , _forwarding_table(other._forwarding_table->clone())
+    , _version(other._version) {}
+
+//! \param[in] route_prefix the address prefix to match destination addresses against
+//! \param[in] prefix_length how many high-order bits of `route_prefix` must match
+//! \param[in] next_hop the IP address of the next hop, or empty if the network is directly attached
+//! \param[in] interface_num the index of the interface to send matching datagrams out on
+//! \param[in] weight the path's share of the route's flows, relative to the route's other paths
+void RoutingTable::add_route(const uint32_t route_prefix,
+                             const uint8_t prefix_length,
+                             const optional<Address> next_hop,
+                             const size_t interface_num,
+                             const uint32_t weight) {
+    if (weight == 0) {
+        throw runtime_error("RoutingTable: a path's weight must be positive");
+    }
+    _version++;
+
+    const auto existing = _route_numbers.find(_key(route_prefix, prefix_length));
+    if (existing != _route_numbers.end()) {
+        Route &route = _routes[existing->second];
+        route.paths.push_back({next_hop, interface_num, weight});
+        route.total_weight += weight;
+        _rebalance(route);
+        return;
+    }
+
+    const auto number = static_cast<uint32_t>(_routes.size());
+    _forwarding_table->insert(route_prefix, prefix_length, number);
+    _routes.push_back({route_prefix, prefix_length, {{next_hop, interface_num, weight}}, weight, {}});
+    _route_numbers.emplace(_key(route_prefix, prefix_length), number);
+}
+
+//! \param[in] route the route that `dgram` matched
+//! \param[in] dgram the datagram being routed
+const RoutingTable::Path &RoutingTable::path(const Route &route, const InternetDatagram &dgram) {
+    if (route.paths.size() == 1) {
+        return route.paths.front();
+    }
+
+    // scale the hash onto the buckets with a multiply and a shift, rather than a division
+    const auto bucket = static_cast<size_t>((uint64_t{flow_hash(dgram)} * route.buckets.size()) >> 32);
+    return route.paths[route.buckets[bucket]];
+}
+
+void RoutingTable::_rebalance(Route &route) {
+    if (route.buckets.empty()) {
+        route.buckets.assign(PATH_BUCKETS, 0);  // the first path had every flow
+    }
+
+    // each path's share of the buckets, rounded down, with the rest going to the largest remainders
+    const size_t num_paths = route.paths.size();
+    vector<size_t> quota(num_paths);
+    vector<pair<uint64_t, size_t>> remainders;
+    size_t assigned = 0;
+    for (size_t i = 0; i < num_paths; i++) {
+        const uint64_t share = PATH_BUCKETS * uint64_t{route.paths[i].weight};
+        quota[i] = share / route.total_weight;
+        assigned += quota[i];
+        remainders.emplace_back(share % route.total_weight, i);
+    }
+    stable_sort(remainders.begin(), remainders.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    for (size_t i = 0; assigned < PATH_BUCKETS; i++, assigned++) {
+        quota[remainders[i].second]++;
+    }
+
+    // free the buckets a path holds beyond its share, and give them to the paths short of theirs
+    vector<size_t> held(num_paths);
+    vector<size_t> freed;
+    for (size_t bucket = 0; bucket < PATH_BUCKETS; bucket++) {
+        const uint32_t path = route.buckets[bucket];
+        if (held[path] < quota[path]) {
+            held[path]++;
+        } else {
+            freed.push_back(bucket);
+        }
+    }
+    size_t path = 0;
+    for (const size_t bucket : freed) {
+        while (held[path] == quota[path]) {
+            path++;
+        }
+        route.buckets[bucket] = static_cast<uint32_t>(path);
+        held[path]++;
+    }
+}
+
+uint32_t RoutingTable::flow_hash(const InternetDatagram &dgram) {
+    const IPv4Header &header = dgram.header();
+    uint64_t ports = 0;
+
+    const bool has_ports = header.proto == IPv4Header::PROTO_TCP or header.proto == IPv4Header::PROTO_UDP;
+    const bool fragment = header.mf or header.offset != 0;
+    if (has_ports and not fragment) {
+        // the source and destination ports are the first four bytes of the TCP or UDP header
+        size_t n = 0;
+        for (const auto &buf : dgram.payload().buffers()) {
+            for (size_t i = 0; i < buf.size() and n < 4; i++, n++) {
+                ports = (ports << 8) | static_cast<uint8_t>(buf.str()[i]);
+            }
+        }
+        if (n < 4) {
+            ports = 0;  // truncated
+        }
+    }
+
+    uint64_t hash = mix64((uint64_t{header.src} << 32) | header.dst);
+    hash = mix64(hash ^ ((uint64_t{header.proto} << 32) | ports));
+    return static_cast<uint32_t>(hash >> 32);
+}
@@ -0,0 +1,111 @@
+#ifndef SPONGE_LIBSPONGE_ROUTING_TABLE_HH
+#define SPONGE_LIBSPONGE_ROUTING_TABLE_HH
+
+#include "address.hh"
+#include "forwarding_table.hh"
+#include "ipv4_datagram.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! \brief A router's routes, and the forwarding table that finds the one matching an address
+
+//! Routes are numbered in the order they were added. A route may have several equal-cost paths
+//! (added by adding the same prefix again); each datagram takes one of them, chosen by a hash of
+//! its flow, so the datagrams of a flow stay in order while flows spread over the paths in
+//! proportion to the paths' weights. The hash picks one of a fixed number of buckets, each assigned
+//! to a path; adding a path reassigns only the buckets it takes over, so only its share of the
+//! flows moves. Lookups only read the table, so threads can route with it
+//! concurrently; to change the routes under them, change a copy and publish it (see RCU).
+class RoutingTable {
+  public:
+    //! One way to reach a route's prefix
+    struct Path {
+        std::optional<Address> next_hop;  //!< where to send; empty for the datagram's own destination
+        size_t interface_num;             //!< which interface to send from
+        uint32_t weight;                  //!< this path's share of the route's flows, relative to the others
+    };
+
+    //! A forwarding rule
+    struct Route {
+        uint32_t route_prefix;          //!< the address prefix the rule applies to
+        uint8_t prefix_length;          //!< number of significant bits in `route_prefix`
+        std::vector<Path> paths;        //!< the equal-cost paths, in the order they were added
+        uint64_t total_weight;          //!< sum of the paths' weights
+        std::vector<uint32_t> buckets;  //!< the path (index in `paths`) of each bucket; empty with one path
+    };
+
+    //! Number of buckets a route with several paths divides its flows into (so weights are honored
+    //! to within 1/PATH_BUCKETS of the flows)
+    static constexpr size_t PATH_BUCKETS = 4096;
+
+  private:
+    //! The routes, in the order they were added
+    std::vector<Route> _routes{};
+
+    //! The number of each route, by its masked prefix and prefix length (see _key())
+    std::unordered_map<uint64_t, uint32_t> _route_numbers{};
+
+    //! Finds the route (by index in `_routes`) with the longest prefix matching an address
+    std::unique_ptr<ForwardingTable> _forwarding_table;
+
+    //! Number of calls to add_route(), including those on the table this one was copied from
+    uint64_t _version{0};
+
+    //! Reassign as few of `route`'s buckets as possible to give each path its share by weight
+    static void _rebalance(Route &route);
+
+    static uint64_t _key(const uint32_t route_prefix, const uint8_t prefix_length) {
+        return (uint64_t{prefix_length} << 32) | (route_prefix & ForwardingTable::mask(prefix_length));
+    }
+
+  public:
+    //! \param[in] forwarding_table the kind of table to look up routes in
+    explicit RoutingTable(const ForwardingTable::Kind forwarding_table = ForwardingTable::Kind::Trie);
+
+    //! \brief A copy of `other`, including its forwarding table
+    RoutingTable(const RoutingTable &other);
+    RoutingTable &operator=(const RoutingTable &other) = delete;
+
+    //! \brief Add a route (a forwarding rule), or another path to an existing route with the same prefix
+    void add_route(const uint32_t route_prefix,
+                   const uint8_t prefix_length,
+                   const std::optional<Address> next_hop,
+                   const size_t interface_num,
+                   const uint32_t weight = 1);
+
+    //! \brief The number of the route with the longest prefix matching `address`, or ForwardingTable::NO_ROUTE
+    uint32_t lookup(const uint32_t address) const { return _forwarding_table->lookup(address); }
+
+    //! \brief See ForwardingTable::prefetch()
+    void prefetch(const uint32_t address) const { _forwarding_table->prefetch(address); }
+
+    //! \brief See ForwardingTable::prefetches()
+    bool prefetches() const { return _forwarding_table->prefetches(); }
+
+    //! \brief A route, by number
+    const Route &route(const uint32_t number) const { return _routes[number]; }
+
+    //! \brief Changes whenever a route is added, e.g. to tell when cached lookups are stale
+    uint64_t version() const { return _version; }
+
+    //! \brief The path that `dgram` takes by `route`
+    static const Path &path(const Route &route, const InternetDatagram &dgram);
+
+    //! \brief A hash of the datagram's flow: its addresses and protocol, and its ports if TCP or UDP
+    //! \details Depends only on the header fields (not on the process or the routes), so a flow
+    //! hashes the same way every time. Fragments are hashed without ports, since only the first
+    //! one carries them.
+    static uint32_t flow_hash(const InternetDatagram &dgram);
+
+    //! \brief Where a datagram to `dst` goes by `path`: its next hop, or `dst` itself if directly attached
+    static uint32_t next_hop(const Path &path, const uint32_t dst) {
+        return path.next_hop.has_value() ? path.next_hop->ipv4_numeric() : dst;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_ROUTING_TABLE_HH
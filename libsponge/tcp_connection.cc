@@ -1,7 +1,9 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
+#include <optional>
 
 // Dummy implementation of a TCP connection
 
@@ -23,8 +25,8 @@ void TCPConnection::_wrap_next_segment_and_send() {
         header.ack = true;
         header.ackno = _receiver.ackno().value();
     }
+    _segments_out.push(move(segment));
     _sender.segments_out().pop();
-    _segments_out.push(segment);
 }
 
 void TCPConnection::_abort_connection() {
@@ -64,9 +66,20 @@ size_t TCPConnection::unassembled_bytes() const { return _receiver.unassembled_b
 
 size_t TCPConnection::time_since_last_segment_received() const { return _time_since_last_segment_received; }
 
-void TCPConnection::segment_received(const TCPSegment &seg) {
+bool TCPConnection::in_time_wait() const {
+    const bool fin_sent = _sender.next_seqno_absolute() == _sender.stream_in().bytes_written() + 2;
+    return _active && _linger_after_streams_finish && _receiver.stream_out().input_ended() &&
+           _sender.stream_in().input_ended() && fin_sent && _sender.bytes_in_flight() == 0;
+}
+
+void TCPConnection::stop_lingering() {
+    if (in_time_wait())
+        _active = false;
+}
+
+TCPConnection::Reply TCPConnection::_receive_segment(const TCPSegment &seg) {
     if (!_active)
-        return;
+        return Reply::NONE;
 
     const TCPHeader &header = seg.header();
     std::optional<WrappingInt32> new_ackno;
@@ -75,14 +88,17 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
     if (header.rst) {
         _abort_connection();
-        return;
+        return Reply::NONE;
     }
 
     if (!_receiver.ackno().has_value() && !header.syn)
-        return;
+        return Reply::NONE;
 
     _receiver.segment_received(seg);
 
+    if (header.syn && header.ack && header.fast_open_cookie.has_value() && !header.fast_open_cookie->empty())
+        _fast_open_cookie_received = header.fast_open_cookie;
+
     if (_receiver.stream_out().input_ended() && !_sender.stream_in().input_ended())
         _linger_after_streams_finish = false;
 
@@ -90,23 +106,59 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         _sender.ack_received(header.ackno, header.win);
 
     new_ackno = _receiver.ackno();
-    if (seg.length_in_sequence_space() > 0) {
+    if (seg.length_in_sequence_space() > 0)
+        return Reply::ACK;
+    if (new_ackno.has_value() && header.seqno == new_ackno.value() - 1)
+        return Reply::KEEPALIVE_ACK;
+    return Reply::NONE;
+}
+
+void TCPConnection::_reply(const Reply reply) {
+    if (reply == Reply::ACK) {
         _sender.fill_window();
         if (_sender.segments_out().empty())
             _sender.send_empty_segment();
-        while (!_sender.segments_out().empty())
-            _wrap_next_segment_and_send();
-    } else if (new_ackno.has_value() && seg.length_in_sequence_space() == 0 && header.seqno == new_ackno.value() - 1) {
+    } else if (reply == Reply::KEEPALIVE_ACK) {
         _sender.send_empty_segment();
-        while (!_sender.segments_out().empty())
-            _wrap_next_segment_and_send();
+    } else {
+        return;
     }
+    while (!_sender.segments_out().empty())
+        _wrap_next_segment_and_send();
+}
 
+void TCPConnection::segment_received(const TCPSegment &seg) {
+    _reply(_receive_segment(seg));
+    _check_connection();
+}
+
+void TCPConnection::segments_received(const vector<TCPSegment> &segs) {
+    Reply reply = Reply::NONE;
+    for (const TCPSegment &seg : segs) {
+        reply = max(reply, _receive_segment(seg));
+    }
+    if (_active)
+        _reply(reply);
     _check_connection();
 }
 
 bool TCPConnection::active() const { return _active; }
 
+optional<size_t> TCPConnection::time_until_next_event() const {
+    if (!_active)
+        return nullopt;
+
+    optional<size_t> next_event = _sender.time_until_timeout();
+    if (_linger_after_streams_finish && _receiver.stream_out().input_ended() && _sender.stream_in().input_ended() &&
+        _sender.bytes_in_flight() == 0) {
+        const size_t linger_time = 10 * _cfg.rt_timeout;
+        const size_t linger_remaining =
+            linger_time > _time_since_last_segment_received ? linger_time - _time_since_last_segment_received : 0;
+        next_event = min(next_event.value_or(linger_remaining), linger_remaining);
+    }
+    return next_event;
+}
+
 size_t TCPConnection::write(const string &data) {
     size_t ret;
 
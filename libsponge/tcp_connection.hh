@@ -6,12 +6,14 @@
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
 
+#include <vector>
+
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
   private:
     TCPConfig _cfg;
     TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn, _cfg.fast_open_cookie};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -24,6 +26,21 @@ class TCPConnection {
 
     size_t _time_since_last_segment_received{0};
 
+    //! TCP Fast Open cookie issued by the peer in its SYN/ACK
+    std::optional<std::string> _fast_open_cookie_received{};
+
+    //! What a received segment calls for in return, in increasing order of what must be sent
+    enum class Reply {
+        NONE,           //!< nothing
+        KEEPALIVE_ACK,  //!< an empty segment acknowledging a keep-alive
+        ACK             //!< an acknowledgment, riding on new data if the window allows
+    };
+
+    //! Update the receiver and sender with an incoming segment, without sending anything
+    Reply _receive_segment(const TCPSegment &seg);
+    //! Send what one or more received segments called for
+    void _reply(const Reply reply);
+
     void _wrap_next_segment_and_send();
     void _abort_connection();
     void _send_rst_segment();
@@ -64,6 +81,15 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief Has the connection finished both streams, and is it only lingering (in TIME_WAIT)?
+    bool in_time_wait() const;
+    //! \brief The TCP Fast Open cookie issued by the peer, if any, for the owner to cache
+    //! (see TCPFastOpenCache) and present when next connecting to the same peer
+    const std::optional<std::string> &fast_open_cookie() const { return _fast_open_cookie_received; }
+    //! \brief Sequence number of the next byte this endpoint would send
+    WrappingInt32 next_seqno() const { return _sender.next_seqno(); }
+    //! \brief The ackno this endpoint advertises to the peer, if the peer's SYN has arrived
+    std::optional<WrappingInt32> ackno() const { return _receiver.ackno(); }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -74,6 +100,12 @@ class TCPConnection {
     //! Called when a new segment has been received from the network
     void segment_received(const TCPSegment &seg);
 
+    //! \brief Called when a burst of segments has been received from the network at once
+    //! \details Each segment updates the receiver and sender in turn, but the connection replies to the
+    //! burst as a whole: at most one acknowledgment (or data segments carrying it) is sent, reflecting
+    //! the window and ackno after the last segment.
+    void segments_received(const std::vector<TCPSegment> &segs);
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
@@ -83,6 +115,20 @@ class TCPConnection {
     //! but could also be user datagrams (UDP) or any other kind).
     std::queue<TCPSegment> &segments_out() { return _segments_out; }
 
+    //! \brief Milliseconds until the next call to tick() could have an effect
+    //! \returns the time until the retransmission timer expires or lingering ends,
+    //! whichever comes first, or empty if neither will happen without further input
+    //! \note An owner driving many connections can use this to tick each one only when needed:
+    //! ticking a connection when this much time has passed, rather than at every step of the
+    //! owner's clock, misses no events. (Ticks must still come at least this often; a single
+    //! tick() covering a longer time retransmits, and backs off the timer, only once.)
+    std::optional<size_t> time_until_next_event() const;
+
+    //! \brief Stop lingering in TIME_WAIT, without sending anything
+    //! \note For an owner that takes over acknowledging the peer's retransmissions itself;
+    //! does nothing unless in_time_wait().
+    void stop_lingering();
+
     //! \brief Is the connection still alive in any way?
     //! \returns `true` if either stream is still running or if the TCPConnection is lingering
     //! after both streams have finished (e.g. to ACK retransmissions from the peer)
@@ -1,6 +1,7 @@
 #include "arp_message.hh"
 
 #include <arpa/inet.h>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -45,31 +46,30 @@ bool ARPMessage::supported() const {
 }
 
 string ARPMessage::serialize() const {
+    string ret(LENGTH, 0);
+    serialize(ret.data());
+    return ret;
+}
+
+void ARPMessage::serialize(char *out) const {
     if (not supported()) {
         throw runtime_error(
             "ARPMessage::serialize(): unsupported field combination (must be Ethernet/IP, and request or reply)");
     }
 
-    string ret;
-    NetUnparser::u16(ret, hardware_type);
-    NetUnparser::u16(ret, protocol_type);
-    NetUnparser::u8(ret, hardware_address_size);
-    NetUnparser::u8(ret, protocol_address_size);
-    NetUnparser::u16(ret, opcode);
+    store_big_endian(out, hardware_type);
+    store_big_endian(out + 2, protocol_type);
+    store_big_endian(out + 4, hardware_address_size);
+    store_big_endian(out + 5, protocol_address_size);
+    store_big_endian(out + 6, opcode);
 
     /* write sender addresses */
-    for (auto &byte : sender_ethernet_address) {
-        NetUnparser::u8(ret, byte);
-    }
-    NetUnparser::u32(ret, sender_ip_address);
+    memcpy(out + 8, sender_ethernet_address.data(), sender_ethernet_address.size());
+    store_big_endian(out + 14, sender_ip_address);
 
     /* write target addresses */
-    for (auto &byte : target_ethernet_address) {
-        NetUnparser::u8(ret, byte);
-    }
-    NetUnparser::u32(ret, target_ip_address);
-
-    return ret;
+    memcpy(out + 18, target_ethernet_address.data(), target_ethernet_address.size());
+    store_big_endian(out + 24, target_ip_address);
 }
 
 string ARPMessage::to_string() const {
@@ -4,6 +4,9 @@
 #include "ethernet_header.hh"
 #include "ipv4_header.hh"
 
+#include <cstring>
+#include <string_view>
+
 using EthernetAddress = std::array<uint8_t, 6>;
 
 //! \brief [ARP](\ref rfc::rfc826) message
@@ -34,6 +37,9 @@ struct ARPMessage {
     //! Serialize the ARP message to a string
     std::string serialize() const;
 
+    //! \brief Serialize the ARP message into `out`, which must have room for LENGTH bytes
+    void serialize(char *out) const;
+
     //! Return a string containing the ARP message in human-readable format
     std::string to_string() const;
 
@@ -44,4 +50,40 @@ struct ARPMessage {
 //! \struct ARPMessage
 //! This struct can be used to parse an existing ARP message or to create a new one.
 
+//! \brief A read-only view of a serialized ARP message, for looking at a few fields without parsing it
+//! \note The accessors other than valid() may only be used if valid() is `true`.
+class ARPMessageView {
+  private:
+    std::string_view _raw;
+
+    EthernetAddress _address(const size_t offset) const {
+        EthernetAddress ret;
+        memcpy(ret.data(), _raw.data() + offset, ret.size());
+        return ret;
+    }
+
+  public:
+    //! \brief Construct a view of the message at the start of `payload` (which must outlive the view)
+    explicit ARPMessageView(const std::string_view payload) : _raw(payload) {}
+
+    //! \brief Is there a complete ARP message here, of a type that ARPMessage supports?
+    bool valid() const {
+        return _raw.size() >= ARPMessage::LENGTH and
+               load_big_endian<uint16_t>(_raw.data()) == ARPMessage::TYPE_ETHERNET and
+               load_big_endian<uint16_t>(_raw.data() + 2) == EthernetHeader::TYPE_IPv4 and
+               static_cast<uint8_t>(_raw[4]) == sizeof(EthernetHeader::src) and
+               static_cast<uint8_t>(_raw[5]) == sizeof(IPv4Header::src) and
+               (opcode() == ARPMessage::OPCODE_REQUEST or opcode() == ARPMessage::OPCODE_REPLY);
+    }
+
+    //! \name ARP message fields
+    //!@{
+    uint16_t opcode() const { return load_big_endian<uint16_t>(_raw.data() + 6); }
+    EthernetAddress sender_ethernet_address() const { return _address(8); }
+    uint32_t sender_ip_address() const { return load_big_endian<uint32_t>(_raw.data() + 14); }
+    EthernetAddress target_ethernet_address() const { return _address(18); }
+    uint32_t target_ip_address() const { return load_big_endian<uint32_t>(_raw.data() + 24); }
+    //!@}
+};
+
 #endif  // SPONGE_LIBSPONGE_ETHERNET_HEADER_HH
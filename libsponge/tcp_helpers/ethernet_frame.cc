@@ -12,13 +12,29 @@ ParseResult EthernetFrame::parse(const Buffer buffer) {
     NetParser p{buffer};
     _header.parse(p);
     _payload = p.buffer();
+    _serialized_header.reset();
 
     return p.get_error();
 }
 
-BufferList EthernetFrame::serialize() const {
-    BufferList ret;
-    ret.append(_header.serialize());
-    ret.append(_payload);
+void EthernetFrame::_prepend_header(BufferList &payload) const {
+    if (_serialized_header.has_value()) {
+        payload.prepend({_serialized_header->data(), EthernetHeader::LENGTH});
+        return;
+    }
+    char header_out[EthernetHeader::LENGTH];
+    _header.serialize(header_out);
+    payload.prepend({header_out, EthernetHeader::LENGTH});
+}
+
+BufferList EthernetFrame::serialize() const & {
+    BufferList ret{_payload};
+    _prepend_header(ret);
+    return ret;
+}
+
+BufferList EthernetFrame::serialize() && {
+    BufferList ret{move(_payload)};
+    _prepend_header(ret);
     return ret;
 }
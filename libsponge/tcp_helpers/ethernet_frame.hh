@@ -4,23 +4,46 @@
 #include "buffer.hh"
 #include "ethernet_header.hh"
 
+#include <array>
+#include <optional>
+
 //! \brief Ethernet frame
 class EthernetFrame {
   private:
     EthernetHeader _header{};
     BufferList _payload{};
 
+    //! The serialized header, if one was supplied with set_header(). (Any modifiable access to the
+    //! header clears this.)
+    std::optional<std::array<char, EthernetHeader::LENGTH>> _serialized_header{};
+
+    //! Prepend the serialized header to `payload`
+    void _prepend_header(BufferList &payload) const;
+
   public:
     //! \brief Parse the frame from a string
     ParseResult parse(const Buffer buffer);
 
     //! \brief Serialize the frame to a string
-    BufferList serialize() const;
+    BufferList serialize() const &;
+
+    //! \brief Serialize the frame to a string, moving the payload into the result
+    BufferList serialize() &&;
+
+    //! \brief Set the header along with its serialization, which serialize() then copies as is
+    //! \note `serialized` must be what `header.serialize()` would produce
+    void set_header(const EthernetHeader &header, const std::array<char, EthernetHeader::LENGTH> &serialized) {
+        _header = header;
+        _serialized_header = serialized;
+    }
 
     //! \name Accessors
     //!@{
     const EthernetHeader &header() const { return _header; }
-    EthernetHeader &header() { return _header; }
+    EthernetHeader &header() {
+        _serialized_header.reset();
+        return _header;
+    }
 
     const BufferList &payload() const { return _payload; }
     BufferList &payload() { return _payload; }
@@ -29,23 +29,20 @@ ParseResult EthernetHeader::parse(NetParser &p) {
 }
 
 string EthernetHeader::serialize() const {
-    string ret;
-    ret.reserve(LENGTH);
+    string ret(LENGTH, 0);
+    serialize(ret.data());
+    return ret;
+}
 
+void EthernetHeader::serialize(char *out) const {
     /* write destination address */
-    for (auto &byte : dst) {
-        NetUnparser::u8(ret, byte);
-    }
+    memcpy(out, dst.data(), dst.size());
 
     /* write source address */
-    for (auto &byte : src) {
-        NetUnparser::u8(ret, byte);
-    }
+    memcpy(out + dst.size(), src.data(), src.size());
 
     /* write the frame's type (e.g. IPv4, ARP or something else) */
-    NetUnparser::u16(ret, type);
-
-    return ret;
+    store_big_endian(out + dst.size() + src.size(), type);
 }
 
 //! \returns A string with a textual representation of an Ethernet address
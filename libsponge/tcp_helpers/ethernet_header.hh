@@ -4,6 +4,8 @@
 #include "parser.hh"
 
 #include <array>
+#include <cstring>
+#include <string_view>
 
 //! Helper type for an Ethernet address (an array of six bytes)
 using EthernetAddress = std::array<uint8_t, 6>;
@@ -33,6 +35,9 @@ struct EthernetHeader {
     //! Serialize the Ethernet fields to a string
     std::string serialize() const;
 
+    //! \brief Serialize the Ethernet fields into `out`, which must have room for LENGTH bytes
+    void serialize(char *out) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 };
@@ -40,4 +45,34 @@ struct EthernetHeader {
 //! \struct EthernetHeader
 //! This struct can be used to parse an existing Ethernet header or to create a new one.
 
+//! \brief A read-only view of a serialized Ethernet header, for looking at a few fields without parsing it
+//! \note The accessors other than valid() may only be used if valid() is `true`.
+class EthernetHeaderView {
+  private:
+    std::string_view _raw;
+
+    EthernetAddress _address(const size_t offset) const {
+        EthernetAddress ret;
+        memcpy(ret.data(), _raw.data() + offset, ret.size());
+        return ret;
+    }
+
+  public:
+    //! \brief Construct a view of the header at the start of `frame` (which must outlive the view)
+    explicit EthernetHeaderView(const std::string_view frame) : _raw(frame) {}
+
+    //! \brief Is there a complete Ethernet header here?
+    bool valid() const { return _raw.size() >= EthernetHeader::LENGTH; }
+
+    //! \name Ethernet header fields
+    //!@{
+    EthernetAddress dst() const { return _address(0); }
+    EthernetAddress src() const { return _address(6); }
+    uint16_t type() const { return load_big_endian<uint16_t>(_raw.data() + 12); }
+    //!@}
+
+    //! \brief The bytes after the header
+    std::string_view payload() const { return _raw.substr(EthernetHeader::LENGTH); }
+};
+
 #endif  // SPONGE_LIBSPONGE_ETHERNET_HEADER_HH
@@ -40,6 +40,9 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! Sends anything the adapter has held back (e.g. segments gathered into a TCP super-packet)
+    void flush() {}
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
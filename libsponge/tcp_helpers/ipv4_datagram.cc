@@ -10,32 +10,65 @@ using namespace std;
 
 ParseResult IPv4Datagram::parse(const Buffer buffer) {
     NetParser p{buffer};
-    _header.parse(p);
+    const ParseResult header_result = _header.parse(p);
     _payload = p.buffer();
+    _checksum_current = false;
 
     if (_payload.size() != _header.payload_length()) {
         return ParseResult::PacketTooShort;
     }
 
+    // serialize() writes options back as zeros, so the received checksum only stays valid without them
+    _checksum_current = not p.error() and header_result == ParseResult::NoError and _header.hlen == 5;
     return p.get_error();
 }
 
-BufferList IPv4Datagram::serialize() const {
+bool IPv4Datagram::decrement_ttl() {
+    if (_header.ttl <= 1) {
+        return false;
+    }
+
+    // TTL and protocol share the 16-bit word at offset 8
+    const uint16_t old_word = (_header.ttl << 8) | _header.proto;
+    _header.ttl--;
+    const uint16_t new_word = (_header.ttl << 8) | _header.proto;
+    _header.cksum = InternetChecksum::adjust(_header.cksum, old_word, new_word);
+    return true;
+}
+
+size_t IPv4Datagram::_serialize_header(char *out) const {
     if (_payload.size() != _header.payload_length()) {
         throw runtime_error("IPv4Datagram::serialize: payload is wrong size");
     }
 
-    IPv4Header header_out = _header;
-    header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
+    const size_t header_length = 4 * _header.hlen;
+    _header.serialize(out);
+
+    // unless the stored checksum is current, calculate it -- taken over header only -- and patch it in
+    if (not _checksum_current) {
+        store_big_endian<uint16_t>(out + 10, 0);
+        InternetChecksum check;
+        check.add({out, header_length});
+        store_big_endian(out + 10, check.value());
+    }
+    return header_length;
+}
+
+BufferList IPv4Datagram::serialize() const & {
+    // serialize the header once, on the stack
+    char header_out[IPv4Header::MAX_LENGTH];
+    const size_t header_length = _serialize_header(header_out);
+
+    BufferList ret{_payload};
+    ret.prepend({header_out, header_length});
+    return ret;
+}
 
-    // calculate checksum -- taken over header only
-    InternetChecksum check;
-    check.add(header_zero_checksum);
-    header_out.cksum = check.value();
+BufferList IPv4Datagram::serialize() && {
+    char header_out[IPv4Header::MAX_LENGTH];
+    const size_t header_length = _serialize_header(header_out);
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+    BufferList ret{move(_payload)};
+    ret.prepend({header_out, header_length});
     return ret;
 }
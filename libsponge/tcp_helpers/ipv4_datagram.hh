@@ -10,17 +10,36 @@ class IPv4Datagram {
     IPv4Header _header{};
     BufferList _payload{};
 
+    //! Does `_header.cksum` match the rest of the header? (It does after parse() or decrement_ttl();
+    //! any modifiable access to the header clears this.)
+    bool _checksum_current{false};
+
+    //! Serialize the header into `out`, recomputing the checksum unless it is current
+    //! \returns the length of the header
+    size_t _serialize_header(char *out) const;
+
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer);
 
     //! \brief Serialize the segment to a string
-    BufferList serialize() const;
+    //! \details Recomputes the header checksum, unless it is known to be current.
+    BufferList serialize() const &;
+
+    //! \brief Serialize the segment to a string, moving the payload into the result
+    BufferList serialize() &&;
+
+    //! \brief Decrement the TTL of a datagram being forwarded, updating the checksum incrementally
+    //! \returns `false` (leaving the datagram unchanged) if the TTL would reach zero
+    bool decrement_ttl();
 
     //! \name Accessors
     //!@{
     const IPv4Header &header() const { return _header; }
-    IPv4Header &header() { return _header; }
+    IPv4Header &header() {
+        _checksum_current = false;
+        return _header;
+    }
 
     const BufferList &payload() const { return _payload; }
     BufferList &payload() { return _payload; }
@@ -3,6 +3,7 @@
 #include "util.hh"
 
 #include <arpa/inet.h>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -76,6 +77,13 @@ ParseResult IPv4Header::parse(NetParser &p) {
 
 //! Serialize the IPv4Header to a string (does not recompute the checksum)
 string IPv4Header::serialize() const {
+    string ret(4 * hlen, 0);
+    serialize(ret.data());
+    return ret;
+}
+
+//! \param[out] out receives the header, without recomputing the checksum
+void IPv4Header::serialize(char *out) const {
     // sanity checks
     if (ver != 4) {
         throw runtime_error("wrong IP version");
@@ -84,29 +92,22 @@ string IPv4Header::serialize() const {
         throw runtime_error("IP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * hlen);
-
     const uint8_t first_byte = (ver << 4) | (hlen & 0xf);
-    NetUnparser::u8(ret, first_byte);  // version and header length
-    NetUnparser::u8(ret, tos);         // type of service
-    NetUnparser::u16(ret, len);        // length
-    NetUnparser::u16(ret, id);         // id
+    store_big_endian(out, first_byte);  // version and header length
+    store_big_endian(out + 1, tos);     // type of service
+    store_big_endian(out + 2, len);     // length
+    store_big_endian(out + 4, id);      // id
 
     const uint16_t fo_val = (df ? 0x4000 : 0) | (mf ? 0x2000 : 0) | (offset & 0x1fff);
-    NetUnparser::u16(ret, fo_val);  // flags and offset
+    store_big_endian(out + 6, fo_val);  // flags and offset
 
-    NetUnparser::u8(ret, ttl);    // time to live
-    NetUnparser::u8(ret, proto);  // protocol number
+    store_big_endian(out + 8, ttl);     // time to live
+    store_big_endian(out + 9, proto);   // protocol number
+    store_big_endian(out + 10, cksum);  // checksum
+    store_big_endian(out + 12, src);    // src address
+    store_big_endian(out + 16, dst);    // dst address
 
-    NetUnparser::u16(ret, cksum);  // checksum
-
-    NetUnparser::u32(ret, src);  // src address
-    NetUnparser::u32(ret, dst);  // dst address
-
-    ret.resize(4 * hlen);  // expand header to advertised size
-
-    return ret;
+    memset(out + IPv4Header::LENGTH, 0, 4 * hlen - IPv4Header::LENGTH);  // expand header to advertised size
 }
 
 uint16_t IPv4Header::payload_length() const { return len - 4 * hlen; }
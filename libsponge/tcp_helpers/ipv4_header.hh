@@ -3,12 +3,16 @@
 
 #include "parser.hh"
 
+#include <string_view>
+
 //! \brief [IPv4](\ref rfc::rfc791) Internet datagram header
 //! \note IP options are not supported
 struct IPv4Header {
     static constexpr size_t LENGTH = 20;         //!< [IPv4](\ref rfc::rfc791) header length, not including options
+    static constexpr size_t MAX_LENGTH = 60;     //!< Longest possible IPv4 header, including options
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
+    static constexpr uint8_t PROTO_UDP = 17;     //!< Protocol number for [udp](\ref rfc::rfc768)
 
     //! \struct IPv4Header
     //! ~~~{.txt}
@@ -52,6 +56,10 @@ struct IPv4Header {
     //! Serialize the IP fields
     std::string serialize() const;
 
+    //! \brief Serialize the IP fields into `out`, which must have room for 4 * `hlen` bytes
+    //! \details Writes each field with a single store; does not allocate.
+    void serialize(char *out) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
@@ -68,4 +76,35 @@ struct IPv4Header {
 //! \struct IPv4Header
 //! This struct can be used to parse an existing IP header or to create a new one.
 
+//! \brief A read-only view of a serialized IPv4 header, for looking at a few fields without parsing it
+//! \details Each accessor decodes its field from the raw bytes with a single load. The checksum is not
+//! verified. The accessors other than valid() may only be used if valid() is `true`.
+class IPv4HeaderView {
+  private:
+    std::string_view _raw;
+
+  public:
+    //! \brief Construct a view of the header at the start of `datagram` (which must outlive the view)
+    explicit IPv4HeaderView(const std::string_view datagram) : _raw(datagram) {}
+
+    //! \brief Is there a complete IPv4 header (including options) here?
+    bool valid() const {
+        return _raw.size() >= IPv4Header::LENGTH and ver() == 4 and hlen() >= 5 and _raw.size() >= 4u * hlen();
+    }
+
+    //! \name IPv4 header fields
+    //!@{
+    uint8_t ver() const { return static_cast<uint8_t>(_raw[0]) >> 4; }
+    uint8_t hlen() const { return static_cast<uint8_t>(_raw[0]) & 0x0f; }
+    uint16_t len() const { return load_big_endian<uint16_t>(_raw.data() + 2); }
+    uint8_t ttl() const { return static_cast<uint8_t>(_raw[8]); }
+    uint8_t proto() const { return static_cast<uint8_t>(_raw[9]); }
+    uint32_t src() const { return load_big_endian<uint32_t>(_raw.data() + 12); }
+    uint32_t dst() const { return load_big_endian<uint32_t>(_raw.data() + 16); }
+    //!@}
+
+    //! \brief The bytes after the header (and its options)
+    std::string_view payload() const { return _raw.substr(4u * hlen()); }
+};
+
 #endif  // SPONGE_LIBSPONGE_IPV4_HEADER_HH
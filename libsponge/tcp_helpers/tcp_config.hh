@@ -7,6 +7,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <string>
 
 //! Config for TCP sender and receiver
 class TCPConfig {
@@ -20,6 +21,25 @@ class TCPConfig {
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+
+    //! TCP Fast Open: cookie to present in the SYN (which may then carry data),
+    //! or an empty string to request a cookie; unset to not use TCP Fast Open
+    std::optional<std::string> fast_open_cookie{};
+};
+
+//! Config for TCPListener
+class TCPListenerConfig {
+  public:
+    static constexpr size_t DEFAULT_BACKLOG = 128;           //!< Default length of the SYN and accept queues
+    static constexpr size_t DEFAULT_FAST_OPEN_BACKLOG = 16;  //!< Default limit on unfinished Fast Open handshakes
+
+    size_t syn_backlog = DEFAULT_BACKLOG;     //!< Maximum number of half-open (SYN_RCVD) connections
+    size_t accept_backlog = DEFAULT_BACKLOG;  //!< Maximum number of established connections awaiting accept()
+    bool syn_cookies = true;                  //!< Answer SYNs statelessly once the SYN backlog is full
+    bool fast_open = false;                   //!< Issue TCP Fast Open cookies, and accept data in SYNs bearing one
+
+    //! Maximum number of connections accepted by TCP Fast Open whose handshake has not finished yet
+    size_t fast_open_backlog = DEFAULT_FAST_OPEN_BACKLOG;
 };
 
 //! Config for classes derived from FdAdapter
@@ -0,0 +1,33 @@
+#ifndef SPONGE_LIBSPONGE_TCP_FAST_OPEN_CACHE_HH
+#define SPONGE_LIBSPONGE_TCP_FAST_OPEN_CACHE_HH
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+//! \brief Client-side cache of [TCP Fast Open](\ref rfc::rfc7413) cookies, by server address
+
+//! Before connecting, the owner sets TCPConfig::fast_open_cookie to
+//! cookie_for() the server: the cached cookie lets the SYN carry data,
+//! and an empty cookie asks the server for one. Once the connection is
+//! established, the owner stores the cookie the server issued (from
+//! TCPConnection::fast_open_cookie()) for next time.
+class TCPFastOpenCache {
+  private:
+    std::unordered_map<uint32_t, std::string> _cookies{};
+
+  public:
+    //! \brief The cookie to present to `server_address`, or an empty string (a cookie request) if none is cached
+    std::string cookie_for(const uint32_t server_address) const {
+        const auto it = _cookies.find(server_address);
+        return it == _cookies.end() ? std::string{} : it->second;
+    }
+
+    //! \brief Remember the cookie issued by `server_address`
+    void store(const uint32_t server_address, const std::string &cookie) { _cookies[server_address] = cookie; }
+
+    //! \brief Forget the cookie for `server_address` (e.g. because the server no longer accepts it)
+    void forget(const uint32_t server_address) { _cookies.erase(server_address); }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_FAST_OPEN_CACHE_HH
@@ -0,0 +1,31 @@
+#ifndef SPONGE_LIBSPONGE_TCP_FOUR_TUPLE_HH
+#define SPONGE_LIBSPONGE_TCP_FOUR_TUPLE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+//! \brief The addresses and ports that identify one TCP connection, seen from the local endpoint
+struct TCPFourTuple {
+    uint32_t local_address = 0;   //!< local IPv4 address (host byte order)
+    uint16_t local_port = 0;      //!< local TCP port
+    uint32_t remote_address = 0;  //!< remote IPv4 address (host byte order)
+    uint16_t remote_port = 0;     //!< remote TCP port
+
+    bool operator==(const TCPFourTuple &other) const {
+        return local_address == other.local_address and local_port == other.local_port and
+               remote_address == other.remote_address and remote_port == other.remote_port;
+    }
+    bool operator!=(const TCPFourTuple &other) const { return not operator==(other); }
+};
+
+//! Hash function so that a TCPFourTuple can key a std::unordered_map
+struct TCPFourTupleHash {
+    size_t operator()(const TCPFourTuple &tuple) const {
+        const uint64_t addresses = (uint64_t{tuple.local_address} << 32) | tuple.remote_address;
+        const uint32_t ports = (uint32_t{tuple.local_port} << 16) | tuple.remote_port;
+        return std::hash<uint64_t>{}(addresses ^ (uint64_t{ports} * 0x9e3779b97f4a7c15));
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_FOUR_TUPLE_HH
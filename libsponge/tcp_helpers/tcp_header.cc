@@ -1,6 +1,8 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
+#include <utility>
 
 using namespace std;
 
@@ -37,8 +39,41 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // look for a TCP Fast Open option, and skip any others
+    fast_open_cookie.reset();
+    size_t options_length = doff * 4 - TCPHeader::LENGTH;
+    while (options_length > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        options_length--;
+        if (kind == OPTION_END) {
+            break;
+        }
+        if (kind == OPTION_NOP) {
+            continue;
+        }
+
+        if (options_length == 0) {
+            break;
+        }
+        const uint8_t length = p.u8();
+        options_length--;
+        if (length < 2 or length - 2u > options_length) {
+            break;  // malformed option: ignore the rest
+        }
+        options_length -= length - 2;
+        if (kind == OPTION_FAST_OPEN) {
+            string cookie;
+            for (uint8_t i = 2; i < length; i++) {
+                cookie.push_back(p.u8());
+            }
+            if (valid_fast_open_cookie(cookie)) {
+                fast_open_cookie = move(cookie);
+            }  // otherwise the option is ignored, as RFC 7413 requires
+        } else {
+            p.remove_prefix(length - 2);
+        }
+    }
+    p.remove_prefix(options_length);
 
     if (p.error()) {
         return p.get_error();
@@ -47,34 +82,54 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
+uint8_t TCPHeader::serialized_doff() const {
+    if (fast_open_cookie.has_value() and not valid_fast_open_cookie(fast_open_cookie.value())) {
+        throw runtime_error("TCP Fast Open cookie has an invalid length");
+    }
+    const size_t options_length = fast_open_cookie.has_value() ? 2 + fast_open_cookie->size() : 0;
+    const size_t header_doff = max<size_t>(doff, (TCPHeader::LENGTH + options_length + 3) / 4);
+    if (4 * header_doff > TCPHeader::MAX_LENGTH) {
+        throw runtime_error("TCP options too long");
+    }
+    return static_cast<uint8_t>(header_doff);
+}
+
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
 string TCPHeader::serialize() const {
+    string ret(4 * serialized_doff(), 0);
+    serialize(ret.data());
+    return ret;
+}
+
+//! \param[out] out receives the header, without recomputing the checksum
+void TCPHeader::serialize(char *out) const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
+    const uint8_t header_doff = serialized_doff();
 
-    string ret;
-    ret.reserve(4 * doff);
-
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    store_big_endian(out, sport);                                        // source port
+    store_big_endian(out + 2, dport);                                    // destination port
+    store_big_endian(out + 4, seqno.raw_value());                        // sequence number
+    store_big_endian(out + 8, ackno.raw_value());                        // ack number
+    store_big_endian(out + 12, static_cast<uint8_t>(header_doff << 4));  // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
-
-    NetUnparser::u16(ret, cksum);  // checksum
-
-    NetUnparser::u16(ret, uptr);  // urgent pointer
-
-    ret.resize(4 * doff);  // expand header to advertised size
-
-    return ret;
+    store_big_endian(out + 13, fl_b);   // flags
+    store_big_endian(out + 14, win);    // window size
+    store_big_endian(out + 16, cksum);  // checksum
+    store_big_endian(out + 18, uptr);   // urgent pointer
+
+    // options, padded with OPTION_END to the advertised size
+    char *option = out + TCPHeader::LENGTH;
+    if (fast_open_cookie.has_value()) {
+        *option++ = static_cast<char>(OPTION_FAST_OPEN);
+        *option++ = static_cast<char>(2 + fast_open_cookie->size());
+        option = copy(fast_open_cookie->begin(), fast_open_cookie->end(), option);
+    }
+    fill(option, out + 4 * header_doff, OPTION_END);
 }
 
 //! \returns A string with the header's contents
@@ -90,13 +145,17 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (fast_open_cookie.has_value()) {
+        ss << "TCP Fast Open cookie: " << dec << fast_open_cookie->size() << " bytes" << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << (fast_open_cookie.has_value() ? ",tfo" : "")
+       << ")";
     return ss.str();
 }
 
@@ -104,5 +163,5 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && fast_open_cookie == other.fast_open_cookie;
 }
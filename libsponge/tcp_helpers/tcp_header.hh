@@ -4,10 +4,27 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <string>
+#include <string_view>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note The only TCP option supported is TCP Fast Open ([RFC 7413](\ref rfc::rfc7413)); others are skipped
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;      //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_LENGTH = 60;  //!< Longest possible TCP header, including options
+
+    static constexpr uint8_t OPTION_END = 0;         //!< End of option list
+    static constexpr uint8_t OPTION_NOP = 1;         //!< No-operation (padding)
+    static constexpr uint8_t OPTION_FAST_OPEN = 34;  //!< TCP Fast Open cookie
+
+    static constexpr size_t MIN_FAST_OPEN_COOKIE = 4;   //!< Shortest TCP Fast Open cookie (other than a request)
+    static constexpr size_t MAX_FAST_OPEN_COOKIE = 16;  //!< Longest TCP Fast Open cookie
+
+    //! \brief Is `cookie` a valid TCP Fast Open option: a cookie of 4 to 16 bytes, or empty to request one?
+    static bool valid_fast_open_cookie(const std::string &cookie) {
+        return cookie.empty() or (cookie.size() >= MIN_FAST_OPEN_COOKIE and cookie.size() <= MAX_FAST_OPEN_COOKIE);
+    }
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,12 +67,22 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \brief TCP Fast Open option: the cookie, or an empty string to request one (unset if the option is absent)
+    std::optional<std::string> fast_open_cookie{};
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
-    //! Serialize the TCP fields
+    //! Serialize the TCP fields (and options, extending `doff` if they need more room)
     std::string serialize() const;
 
+    //! \brief Serialize the TCP fields and options into `out`, which must have room for 4 * serialized_doff() bytes
+    //! \details Writes each field with a single store; does not allocate.
+    void serialize(char *out) const;
+
+    //! The data offset of the serialized header: `doff`, or more if the options need more room
+    uint8_t serialized_doff() const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -65,4 +92,40 @@ struct TCPHeader {
     bool operator==(const TCPHeader &other) const;
 };
 
+//! \brief A read-only view of a serialized TCP header, for looking at a few fields without parsing it
+//! \details Each accessor decodes its field from the raw bytes with a single load. The checksum is not
+//! verified. The accessors other than valid() may only be used if valid() is `true`.
+class TCPHeaderView {
+  private:
+    std::string_view _raw;
+
+    bool _flag(const uint8_t mask) const { return static_cast<uint8_t>(_raw[13]) & mask; }
+
+  public:
+    //! \brief Construct a view of the header at the start of `segment` (which must outlive the view)
+    explicit TCPHeaderView(const std::string_view segment) : _raw(segment) {}
+
+    //! \brief Is there a complete TCP header (including options) here?
+    bool valid() const { return _raw.size() >= TCPHeader::LENGTH and doff() >= 5 and _raw.size() >= 4u * doff(); }
+
+    //! \name TCP header fields
+    //!@{
+    uint16_t sport() const { return load_big_endian<uint16_t>(_raw.data()); }
+    uint16_t dport() const { return load_big_endian<uint16_t>(_raw.data() + 2); }
+    WrappingInt32 seqno() const { return WrappingInt32{load_big_endian<uint32_t>(_raw.data() + 4)}; }
+    WrappingInt32 ackno() const { return WrappingInt32{load_big_endian<uint32_t>(_raw.data() + 8)}; }
+    uint8_t doff() const { return static_cast<uint8_t>(_raw[12]) >> 4; }
+    bool urg() const { return _flag(0b0010'0000); }
+    bool ack() const { return _flag(0b0001'0000); }
+    bool psh() const { return _flag(0b0000'1000); }
+    bool rst() const { return _flag(0b0000'0100); }
+    bool syn() const { return _flag(0b0000'0010); }
+    bool fin() const { return _flag(0b0000'0001); }
+    uint16_t win() const { return load_big_endian<uint16_t>(_raw.data() + 14); }
+    //!@}
+
+    //! \brief The bytes after the header (and its options)
+    std::string_view payload() const { return _raw.substr(4u * doff()); }
+};
+
 #endif  // SPONGE_LIBSPONGE_TCP_HEADER_HH
@@ -23,7 +23,8 @@ using namespace std;
 //! `_listen` flag and records the source and destination addresses and port numbers
 //! from the TCP header; it uses this information to filter future reads.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
-optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram) {
+optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram,
+                                                          const bool checksum_verified) {
     // is the IPv4 datagram for us?
     // Note: it's valid to bind to address "0" (INADDR_ANY) and reply from actual address contacted
     if (not listening() and (ip_dgram.header().dst != config().source.ipv4_numeric())) {
@@ -42,7 +43,8 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
 
     // is the payload a valid TCP segment?
     TCPSegment tcp_seg;
-    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+    if (ParseResult::NoError !=
+        tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum(), not checksum_verified)) {
         return {};
     }
 
@@ -70,6 +72,33 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
     return tcp_seg;
 }
 
+//! \details Datagrams that are not TCP, or are not related to the current connection, are dropped by
+//! looking at the raw IPv4 and TCP headers, before anything is parsed or checksummed.
+optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const Buffer &datagram, const bool checksum_verified) {
+    const IPv4HeaderView ip_header{datagram};
+    if (not ip_header.valid() or ip_header.proto() != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+    if (not listening() and (ip_header.dst() != config().source.ipv4_numeric() or
+                             ip_header.src() != config().destination.ipv4_numeric())) {
+        return {};
+    }
+
+    const TCPHeaderView tcp_header{ip_header.payload()};
+    if (not tcp_header.valid() or tcp_header.dport() != config().source.port()) {
+        return {};
+    }
+    if (not listening() and tcp_header.sport() != config().destination.port()) {
+        return {};
+    }
+
+    InternetDatagram ip_dgram;
+    if (ip_dgram.parse(datagram) != ParseResult::NoError) {
+        return {};
+    }
+    return unwrap_tcp_in_ip(ip_dgram, checksum_verified);
+}
+
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
 //! \param[in] seg is the TCP segment to convert
 InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
@@ -81,10 +110,74 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
     InternetDatagram ip_dgram;
     ip_dgram.header().src = config().source.ipv4_numeric();
     ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + 4 * seg.header().serialized_doff() + seg.payload().size();
 
     // set payload, calculating TCP checksum using information from IP header
     ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
 
     return ip_dgram;
 }
+
+//! \param[in] seg is the TCP segment to send in the super-packet
+bool TCPOverIPv4Adapter::gather_for_offload(TCPSegment &seg) {
+    if (not _offload_segments.empty()) {
+        const TCPSegment &last = _offload_segments.back();
+        const TCPHeader &last_header = last.header();
+        const TCPHeader &header = seg.header();
+
+        // the device copies the first segment's header into each segment, adjusting only the
+        // seqno, and setting PSH and FIN only on the last one
+        const bool plain = not(last_header.syn or last_header.fin or last_header.rst or last_header.urg or
+                               last_header.psh or header.syn or header.rst or header.urg) and
+                           last_header.doff == TCPHeader::LENGTH / 4 and header.doff == TCPHeader::LENGTH / 4;
+        const bool consecutive = last.payload().size() == TCPConfig::MAX_PAYLOAD_SIZE and
+                                 header.seqno == last_header.seqno + TCPConfig::MAX_PAYLOAD_SIZE;
+        const bool same_fields =
+            header.ack == last_header.ack and header.ackno == last_header.ackno and header.win == last_header.win;
+        if (not plain or not consecutive or not same_fields or seg.payload().size() == 0 or
+            _offload_payload_size + seg.payload().size() > MAX_OFFLOAD_PAYLOAD) {
+            return false;
+        }
+    }
+
+    _offload_segments.push_back(seg);
+    _offload_payload_size += seg.payload().size();
+    return true;
+}
+
+optional<InternetDatagram> TCPOverIPv4Adapter::take_offloaded() {
+    if (_offload_segments.empty()) {
+        return {};
+    }
+
+    // the first segment's header, with the last segment's PSH and FIN
+    TCPHeader header = _offload_segments.front().header();
+    header.psh = _offload_segments.back().header().psh;
+    header.fin = _offload_segments.back().header().fin;
+    header.sport = config().source.port();
+    header.dport = config().destination.port();
+    const size_t header_length = 4 * header.serialized_doff();
+
+    InternetDatagram ip_dgram;
+    ip_dgram.header().src = config().source.ipv4_numeric();
+    ip_dgram.header().dst = config().destination.ipv4_numeric();
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + header_length + _offload_payload_size;
+
+    // the device completes the checksum, starting from the pseudo-header's (uncomplemented) sum
+    header.cksum = static_cast<uint16_t>(~InternetChecksum{ip_dgram.header().pseudo_cksum()}.value());
+    char header_out[TCPHeader::MAX_LENGTH];
+    header.serialize(header_out);
+
+    BufferList payload;
+    for (const auto &seg : _offload_segments) {
+        if (seg.payload().size() > 0) {
+            payload.append(seg.payload());
+        }
+    }
+    payload.prepend({header_out, header_length});
+    ip_dgram.payload() = move(payload);
+
+    _offload_segments.clear();
+    _offload_payload_size = 0;
+    return ip_dgram;
+}
@@ -7,13 +7,41 @@
 #include "tcp_segment.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
   public:
-    std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
+    //! Largest payload of a TCP super-packet (so that its IPv4 length still fits in 16 bits)
+    static constexpr size_t MAX_OFFLOAD_PAYLOAD = 65535 - IPv4Header::LENGTH - TCPHeader::LENGTH;
+
+  private:
+    //! Segments gathered for a TCP super-packet (see gather_for_offload())
+    std::vector<TCPSegment> _offload_segments{};
+
+    //! Total payload of `_offload_segments`
+    size_t _offload_payload_size{0};
+
+  public:
+    //! \note With `checksum_verified`, the TCP checksum is not checked (see TCPSegment::parse()).
+    std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram, const bool checksum_verified = false);
+
+    //! \brief Parse a serialized IPv4 datagram and unwrap the TCP segment in it, if it is related to the connection
+    std::optional<TCPSegment> unwrap_tcp_in_ip(const Buffer &datagram, const bool checksum_verified = false);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! \brief Gather `seg` into the TCP super-packet being built for a device with segmentation offload
+    //! \details A super-packet is a run of consecutive full-sized (TCPConfig::MAX_PAYLOAD_SIZE) segments,
+    //! plus possibly one shorter segment, with the same ackno, window and flags.
+    //! \returns `false` (leaving `seg` out) if it cannot join the segments gathered so far, which should
+    //! then be sent with take_offloaded() first
+    bool gather_for_offload(TCPSegment &seg);
+
+    //! \brief Wrap the gathered segments in one IPv4 datagram (empty if none were gathered)
+    //! \details The TCP checksum field holds only the pseudo-header's sum, for the device to complete
+    //! (see VirtioNetHeader::for_packet()).
+    std::optional<InternetDatagram> take_offloaded();
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
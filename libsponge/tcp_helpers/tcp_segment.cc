@@ -9,11 +9,14 @@ using namespace std;
 
 //! \param[in] buffer string/Buffer to be parsed
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(buffer);
-    if (check.value()) {
-        return ParseResult::BadChecksum;
+//! \param[in] verify_checksum whether to check the checksum
+ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum, const bool verify_checksum) {
+    if (verify_checksum) {
+        InternetChecksum check(datagram_layer_checksum);
+        check.add(buffer);
+        if (check.value()) {
+            return ParseResult::BadChecksum;
+        }
     }
 
     NetParser p{buffer};
@@ -26,20 +29,80 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+bool TCPSegment::_can_patch(const uint32_t datagram_layer_checksum) const {
+    const SerializedHeader &cached = *_serialized;
+    if (cached.length == 0 or cached.datagram_layer_checksum != datagram_layer_checksum or
+        cached.payload.str().data() != _payload.str().data() or cached.payload.size() != _payload.size()) {
+        return false;
+    }
+    TCPHeader header = _header;
+    header.ackno = cached.header.ackno;
+    header.win = cached.header.win;
+    header.ack = cached.header.ack;
+    return header == cached.header and header.sport == cached.header.sport and header.dport == cached.header.dport;
+}
+
+void TCPSegment::_patch() const {
+    SerializedHeader &cached = *_serialized;
+    char *const bytes = cached.bytes.data();
+    uint16_t cksum = load_big_endian<uint16_t>(bytes + 16);
+
+    cksum = InternetChecksum::adjust(cksum, cached.header.ackno.raw_value(), _header.ackno.raw_value());
+    store_big_endian(bytes + 8, _header.ackno.raw_value());
+
+    // the ACK flag shares a 16-bit word with the data offset
+    const uint16_t old_flags = load_big_endian<uint16_t>(bytes + 12);
+    const uint16_t new_flags = (old_flags & ~0b0001'0000) | (_header.ack ? 0b0001'0000 : 0);
+    cksum = InternetChecksum::adjust(cksum, old_flags, new_flags);
+    store_big_endian(bytes + 12, new_flags);
+
+    cksum = InternetChecksum::adjust(cksum, cached.header.win, _header.win);
+    store_big_endian(bytes + 14, _header.win);
+
+    store_big_endian(bytes + 16, cksum);
+    cached.header.ackno = _header.ackno;
+    cached.header.win = _header.win;
+    cached.header.ack = _header.ack;
+}
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    TCPHeader header_out = _header;
-    header_out.cksum = 0;
+    char stack_out[TCPHeader::MAX_LENGTH];
+    char *const header_out = _serialized ? _serialized->bytes.data() : stack_out;
+
+    // a retransmission only needs the fields that changed patched in
+    if (_serialized and _can_patch(datagram_layer_checksum)) {
+        _patch();
+        BufferList ret{_payload};
+        ret.prepend({header_out, _serialized->length});
+        return ret;
+    }
 
-    // calculate checksum -- taken over entire segment
+    // serialize the header once, with a zero checksum
+    const size_t header_length = 4 * _header.serialized_doff();
+    _header.serialize(header_out);
+    store_big_endian<uint16_t>(header_out + 16, 0);
+
+    // calculate checksum -- taken over entire segment -- and patch it in
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
-    check.add(_payload);
-    header_out.cksum = check.value();
+    check.add({header_out, header_length});
+    const auto payload_checksum = _payload.checksum();
+    if (payload_checksum.has_value()) {
+        check.add(*payload_checksum);  // summed when the payload was copied into its Buffer
+    } else {
+        check.add(_payload);
+    }
+    store_big_endian(header_out + 16, check.value());
+
+    if (_serialized) {
+        _serialized->header = _header;
+        _serialized->datagram_layer_checksum = datagram_layer_checksum;
+        _serialized->payload = _payload;
+        _serialized->length = header_length;
+    }
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+    BufferList ret{_payload};
+    ret.prepend({header_out, header_length});
 
     return ret;
 }
@@ -4,7 +4,10 @@
 #include "buffer.hh"
 #include "tcp_header.hh"
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <utility>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
@@ -12,13 +15,85 @@ class TCPSegment {
     TCPHeader _header{};
     Buffer _payload{};
 
+    //! The last serialization of a segment, kept so that its retransmissions can be patched
+    struct SerializedHeader {
+        TCPHeader header{};                               //!< the header that was serialized
+        uint32_t datagram_layer_checksum{};               //!< the pseudo-checksum it was serialized with
+        Buffer payload{};                                 //!< the payload it was serialized with (kept alive)
+        std::array<char, TCPHeader::MAX_LENGTH> bytes{};  //!< the serialized header, with its checksum
+        size_t length{};                                  //!< how many of `bytes` are the header
+        size_t refs{1};                                   //!< number of segments sharing it
+    };
+
+    //! \brief A reference-counted handle to a SerializedHeader
+    //! \note The count is not atomic (a segment and its copies stay on one thread), so copying
+    //! a segment costs no more than copying its payload Buffer.
+    class SerializedHeaderRef {
+      private:
+        SerializedHeader *_cached{nullptr};
+
+        void _release() {
+            if (_cached and --_cached->refs == 0) {
+                delete _cached;
+            }
+        }
+
+      public:
+        SerializedHeaderRef() = default;
+        explicit SerializedHeaderRef(SerializedHeader *cached) : _cached(cached) {}
+
+        SerializedHeaderRef(const SerializedHeaderRef &other) : _cached(other._cached) {
+            if (_cached) {
+                _cached->refs++;
+            }
+        }
+        SerializedHeaderRef(SerializedHeaderRef &&other) noexcept : _cached(std::exchange(other._cached, nullptr)) {}
+        SerializedHeaderRef &operator=(const SerializedHeaderRef &other) {
+            SerializedHeaderRef copy{other};
+            std::swap(_cached, copy._cached);
+            return *this;
+        }
+        SerializedHeaderRef &operator=(SerializedHeaderRef &&other) noexcept {
+            std::swap(_cached, other._cached);
+            return *this;
+        }
+        ~SerializedHeaderRef() { _release(); }
+
+        explicit operator bool() const { return _cached != nullptr; }
+        const SerializedHeader &operator*() const { return *_cached; }
+        SerializedHeader &operator*() { return *_cached; }
+        const SerializedHeader *operator->() const { return _cached; }
+        SerializedHeader *operator->() { return _cached; }
+    };
+
+    //! Shared by the copies of the segment, if cache_serialization() was called. It is only a
+    //! cache: serialize() fills it in and patches it, but what serialize() returns depends only
+    //! on the header and payload, so serialize() stays logically const.
+    mutable SerializedHeaderRef _serialized{};
+
+    //! Can the cached header be patched to serialize this segment? (Only ackno, window and ACK may differ.)
+    bool _can_patch(const uint32_t datagram_layer_checksum) const;
+
+    //! Patch ackno, window and ACK, and adjust the checksum to match, in the cached header
+    void _patch() const;
+
   public:
     //! \brief Parse the segment from a string
-    ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
+    //! \note With `verify_checksum` false, the checksum is not checked (e.g. because the kernel already did, or
+    //! because the segment came from the local host with a partial checksum).
+    ParseResult parse(const Buffer buffer,
+                      const uint32_t datagram_layer_checksum = 0,
+                      const bool verify_checksum = true);
 
     //! \brief Serialize the segment to a string
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Keep the serialized header, shared by all later copies of this segment
+    //! \details Serializing a copy that differs only in ackno, window and the ACK flag (as a
+    //! retransmission does) then patches those fields and the checksum, rather than serializing the
+    //! header and summing the payload again.
+    void cache_serialization() { _serialized = SerializedHeaderRef{new SerializedHeader{}}; }
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
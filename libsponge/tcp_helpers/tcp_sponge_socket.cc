@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <exception>
 #include <iostream>
+#include <poll.h>
 #include <stdexcept>
 #include <string>
 #include <sys/socket.h>
@@ -15,11 +16,21 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 using namespace std;
 
 static constexpr size_t TCP_TICK_MS = 10;
 
+//! Most segments to read from the datagram adapter before handing them to the TCPConnection
+static constexpr size_t TCP_MAX_BURST = 64;
+
+//! Could `fd` be read right now without blocking?
+static bool readable_now(const FileDescriptor &fd) {
+    pollfd pfd{fd.fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 0)) > 0 and (pfd.revents & POLLIN);
+}
+
 //! \param[in] condition is a function returning true if loop should continue
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
@@ -76,9 +87,17 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
+                            // read everything that has already arrived (up to a limit), and hand it
+                            // to the TCPConnection as one burst, so that it replies with one ACK
+                            vector<TCPSegment> burst;
+                            do {
+                                auto seg = _datagram_adapter.read();
+                                if (seg) {
+                                    burst.push_back(move(seg.value()));
+                                }
+                            } while (burst.size() < TCP_MAX_BURST and readable_now(_datagram_adapter));
+                            if (not burst.empty()) {
+                                _tcp->segments_received(burst);
                             }
 
                             // debugging output:
@@ -158,6 +177,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                                 _datagram_adapter.write(_tcp->segments_out().front());
                                 _tcp->segments_out().pop();
                             }
+                            _datagram_adapter.flush();
                         },
                         [&] { return not _tcp->segments_out().empty(); });
 }
@@ -1,7 +1,63 @@
 #include "tuntap_adapter.hh"
 
+#include "virtio_net_header.hh"
+
 using namespace std;
 
+//! \brief Write `packet` to `device`, preceded by a virtio-net header if the device has offloads
+//! \param[in] ip_offset where the IPv4 header (if any) starts in `packet`
+static void write_packet(TunTapFD &device, BufferList packet, const size_t ip_offset) {
+    if (device.vnet_hdr()) {
+        packet.prepend(VirtioNetHeader::for_packet(packet, ip_offset).serialize());
+    }
+    device.write(packet);
+}
+
+//! \brief Read a packet from `device`, removing the virtio-net header if the device has offloads
+//! \param[out] checksum_verified is set if the packet's TCP checksum need not be checked
+//! \returns the packet, or an empty Buffer if it was malformed
+static Buffer read_packet(TunTapFD &device, bool &checksum_verified) {
+    Buffer packet{device.read()};
+    checksum_verified = false;
+    if (not device.vnet_hdr()) {
+        return packet;
+    }
+
+    VirtioNetHeader vnet;
+    if (vnet.parse(packet) != ParseResult::NoError) {
+        return {};
+    }
+    packet.remove_prefix(VirtioNetHeader::LENGTH);
+    // a partial checksum means the packet came from this host (possibly coalesced by GRO)
+    checksum_verified = vnet.flags & (VirtioNetHeader::FLAG_NEEDS_CSUM | VirtioNetHeader::FLAG_DATA_VALID);
+    return packet;
+}
+
+optional<TCPSegment> TCPOverIPv4OverTunFdAdapter::read() {
+    bool checksum_verified;
+    const Buffer datagram = read_packet(_tun, checksum_verified);
+    return unwrap_tcp_in_ip(datagram, checksum_verified);
+}
+
+//! \param[in] seg the TCPSegment to send
+void TCPOverIPv4OverTunFdAdapter::write(TCPSegment &seg) {
+    if (not _tun.vnet_hdr()) {
+        write_packet(_tun, wrap_tcp_in_ip(seg).serialize(), 0);
+        return;
+    }
+    if (not gather_for_offload(seg)) {
+        flush();
+        gather_for_offload(seg);
+    }
+}
+
+void TCPOverIPv4OverTunFdAdapter::flush() {
+    const auto ip_dgram = take_offloaded();
+    if (ip_dgram) {
+        write_packet(_tun, ip_dgram->serialize(), 0);
+    }
+}
+
 //! \param[in] tap Raw network device that will be owned by the adapter
 //! \param[in] eth_address Ethernet address (local address) of the adapter
 //! \param[in] ip_address IP address (local address) of the adapter
@@ -13,25 +69,21 @@ TCPOverIPv4OverEthernetAdapter::TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
     : _tap(move(tap)), _interface(eth_address, ip_address), _next_hop(next_hop) {
     // Linux seems to ignore the first frame sent on a TAP device, so send a dummy frame to prime the pump :-(
     EthernetFrame dummy_frame;
-    _tap.write(dummy_frame.serialize());
+    write_packet(_tap, dummy_frame.serialize(), EthernetHeader::LENGTH);
 }
 
 optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
-    // Read Ethernet frame from the raw device
-    EthernetFrame frame;
-    if (frame.parse(_tap.read()) != ParseResult::NoError) {
-        return {};
-    }
-
-    // Give the frame to the NetworkInterface. Get back an Internet datagram if frame was carrying one.
-    optional<InternetDatagram> ip_dgram = _interface.recv_frame(frame);
+    // Read an Ethernet frame from the raw device, and give it to the NetworkInterface.
+    // Get back an Internet datagram if frame was carrying one.
+    bool checksum_verified;
+    optional<InternetDatagram> ip_dgram = _interface.recv_serialized_frame(read_packet(_tap, checksum_verified));
 
     // The incoming frame may have caused the NetworkInterface to send a frame.
     send_pending();
 
     // Try to interpret IPv4 datagram as TCP
     if (ip_dgram) {
-        return unwrap_tcp_in_ip(ip_dgram.value());
+        return unwrap_tcp_in_ip(ip_dgram.value(), checksum_verified);
     }
     return {};
 }
@@ -44,13 +96,28 @@ void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
 
 //! \param[in] seg the TCPSegment to send
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
-    _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
-    send_pending();
+    if (not _tap.vnet_hdr()) {
+        _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+        send_pending();
+        return;
+    }
+    if (not gather_for_offload(seg)) {
+        flush();
+        gather_for_offload(seg);
+    }
+}
+
+void TCPOverIPv4OverEthernetAdapter::flush() {
+    const auto ip_dgram = take_offloaded();
+    if (ip_dgram) {
+        _interface.send_datagram(*ip_dgram, _next_hop);
+        send_pending();
+    }
 }
 
 void TCPOverIPv4OverEthernetAdapter::send_pending() {
     while (not _interface.frames_out().empty()) {
-        _tap.write(_interface.frames_out().front().serialize());
+        write_packet(_tap, _interface.frames_out().front().serialize(), EthernetHeader::LENGTH);
         _interface.frames_out().pop();
     }
 }
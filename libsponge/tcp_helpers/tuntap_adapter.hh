@@ -19,16 +19,15 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) {}
 
     //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
-    std::optional<TCPSegment> read() {
-        InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
-            return {};
-        }
-        return unwrap_tcp_in_ip(ip_dgram);
-    }
+    std::optional<TCPSegment> read();
+
+    //! \brief Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
+    //! \details If the device has offloads (TunTapFD::vnet_hdr()), consecutive segments are instead gathered
+    //! into a TCP super-packet, written by flush() (or when a segment cannot join it).
+    void write(TCPSegment &seg);
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Writes the TCP super-packet gathered so far, if any
+    void flush();
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -60,9 +59,14 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
     std::optional<TCPSegment> read();
 
-    //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
+    //! \brief Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
+    //! \details If the device has offloads (TunTapFD::vnet_hdr()), consecutive segments are instead gathered
+    //! into a TCP super-packet, sent by flush() (or when a segment cannot join it).
     void write(TCPSegment &seg);
 
+    //! Sends the TCP super-packet gathered so far, if any
+    void flush();
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
@@ -0,0 +1,77 @@
+#include "virtio_net_header.hh"
+
+#include "ethernet_header.hh"
+#include "ipv4_header.hh"
+#include "tcp_config.hh"
+#include "tcp_header.hh"
+
+#include <array>
+#include <cstring>
+
+using namespace std;
+
+//! \param[in] raw the bytes read from the device, starting with the header
+ParseResult VirtioNetHeader::parse(const string_view raw) {
+    if (raw.size() < LENGTH) {
+        return ParseResult::PacketTooShort;
+    }
+    flags = raw[0];
+    gso_type = raw[1];
+    memcpy(&hdr_len, raw.data() + 2, sizeof(hdr_len));
+    memcpy(&gso_size, raw.data() + 4, sizeof(gso_size));
+    memcpy(&csum_start, raw.data() + 6, sizeof(csum_start));
+    memcpy(&csum_offset, raw.data() + 8, sizeof(csum_offset));
+    return ParseResult::NoError;
+}
+
+string VirtioNetHeader::serialize() const {
+    string ret(LENGTH, 0);
+    ret[0] = static_cast<char>(flags);
+    ret[1] = static_cast<char>(gso_type);
+    memcpy(ret.data() + 2, &hdr_len, sizeof(hdr_len));
+    memcpy(ret.data() + 4, &gso_size, sizeof(gso_size));
+    memcpy(ret.data() + 6, &csum_start, sizeof(csum_start));
+    memcpy(ret.data() + 8, &csum_offset, sizeof(csum_offset));
+    return ret;
+}
+
+//! \param[in] packet the serialized packet, whose TCP checksum field holds the pseudo-header's sum
+//! \param[in] ip_offset where the IPv4 header starts in `packet`
+VirtioNetHeader VirtioNetHeader::for_packet(const BufferList &packet, const size_t ip_offset) {
+    // gather the headers, which may span several Buffers
+    array<char, EthernetHeader::LENGTH + IPv4Header::MAX_LENGTH + TCPHeader::MAX_LENGTH> headers{};
+    size_t gathered = 0;
+    for (const auto &buf : packet.buffers()) {
+        const size_t n = min(buf.size(), headers.size() - gathered);
+        memcpy(headers.data() + gathered, buf.str().data(), n);
+        gathered += n;
+        if (gathered == headers.size()) {
+            break;
+        }
+    }
+
+    VirtioNetHeader ret;
+    if (gathered < ip_offset) {
+        return ret;
+    }
+    const IPv4HeaderView ip_header{{headers.data() + ip_offset, gathered - ip_offset}};
+    if (not ip_header.valid() or ip_header.proto() != IPv4Header::PROTO_TCP) {
+        return ret;
+    }
+    const TCPHeaderView tcp_header{ip_header.payload()};
+    if (not tcp_header.valid()) {
+        return ret;
+    }
+
+    const size_t tcp_start = ip_offset + 4 * ip_header.hlen();
+    const size_t headers_length = tcp_start + 4 * tcp_header.doff();
+    ret.flags = FLAG_NEEDS_CSUM;
+    ret.csum_start = static_cast<uint16_t>(tcp_start);
+    ret.csum_offset = 16;  // the TCP checksum field
+    ret.hdr_len = static_cast<uint16_t>(headers_length);
+    if (packet.size() - headers_length > TCPConfig::MAX_PAYLOAD_SIZE) {
+        ret.gso_type = GSO_TCPV4;
+        ret.gso_size = TCPConfig::MAX_PAYLOAD_SIZE;
+    }
+    return ret;
+}
@@ -0,0 +1,48 @@
+#ifndef SPONGE_LIBSPONGE_VIRTIO_NET_HEADER_HH
+#define SPONGE_LIBSPONGE_VIRTIO_NET_HEADER_HH
+
+#include "buffer.hh"
+#include "parser.hh"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//! \brief The [virtio-net](https://docs.oasis-open.org/virtio/virtio/v1.1/virtio-v1.1.html) header that
+//! precedes every packet on a TunTapFD opened with `vnet_hdr`
+//! \details Describes the offloads of the packet that follows: a checksum that is still to be completed,
+//! and whether the packet is a TCP super-packet, to be split into segments of `gso_size` bytes of payload
+//! (when written) or coalesced from such segments by the kernel (when read). The fields are in the
+//! host's byte order.
+struct VirtioNetHeader {
+    static constexpr size_t LENGTH = 10;  //!< Length of the (legacy) header in bytes
+
+    static constexpr uint8_t FLAG_NEEDS_CSUM = 1;  //!< The checksum at `csum_start + csum_offset` is partial
+    static constexpr uint8_t FLAG_DATA_VALID = 2;  //!< The checksums were verified by the kernel
+    static constexpr uint8_t GSO_NONE = 0;         //!< An ordinary packet
+    static constexpr uint8_t GSO_TCPV4 = 1;        //!< A TCP-over-IPv4 super-packet
+
+    //! \name virtio-net header fields
+    //!@{
+    uint8_t flags = 0;         //!< FLAG_NEEDS_CSUM and/or FLAG_DATA_VALID
+    uint8_t gso_type = 0;      //!< GSO_NONE or GSO_TCPV4
+    uint16_t hdr_len = 0;      //!< length of the headers copied into each segment of a super-packet
+    uint16_t gso_size = 0;     //!< payload length of each segment of a super-packet
+    uint16_t csum_start = 0;   //!< where the partial checksum's coverage starts
+    uint16_t csum_offset = 0;  //!< where the checksum is, relative to `csum_start`
+    //!@}
+
+    //! Parse the header from the front of `raw`
+    ParseResult parse(const std::string_view raw);
+
+    //! Serialize the header to a string
+    std::string serialize() const;
+
+    //! \brief The offloads for a TCP-over-IPv4 packet whose TCP checksum covers only the pseudo-header
+    //! \details The IPv4 header starts `ip_offset` bytes into `packet` (after any link-layer header).
+    //! The packet is a super-packet if its payload exceeds TCPConfig::MAX_PAYLOAD_SIZE. Other packets
+    //! need no offloads.
+    static VirtioNetHeader for_packet(const BufferList &packet, const size_t ip_offset);
+};
+
+#endif  // SPONGE_LIBSPONGE_VIRTIO_NET_HEADER_HH
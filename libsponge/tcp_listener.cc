@@ -0,0 +1,378 @@
+#include "tcp_listener.hh"
+
+#include "util.hh"
+
+#include <limits>
+#include <tuple>
+
+using namespace std;
+
+//! \param[in] cfg the configuration of each connection accepted by the listener
+//! \param[in] listener_cfg the sizes of the SYN and accept queues, and whether to use SYN cookies
+TCPListener::TCPListener(const TCPConfig &cfg, const TCPListenerConfig &listener_cfg)
+    : _cfg(cfg)
+    , _listener_cfg(listener_cfg)
+    , _rand(get_random_generator())
+    , _cookie_secret((uint64_t{_rand()} << 32) | _rand()) {}
+
+//! \details The layout of a SYN cookie is
+//! ~~~{.txt}
+//!   31     27 26                                                   0
+//!  +---------+------------------------------------------------------+
+//!  | period  |  keyed hash of (four-tuple, peer's ISN, full period) |
+//!  +---------+------------------------------------------------------+
+//! ~~~
+//! where `period` counts intervals of SYN_COOKIE_PERIOD milliseconds (modulo 32).
+WrappingInt32 TCPListener::_syn_cookie(const TCPFourTuple &tuple,
+                                       const WrappingInt32 peer_isn,
+                                       const uint64_t period) const {
+    uint64_t hash = _cookie_secret;
+    hash = mix64(hash ^ ((uint64_t{tuple.local_address} << 32) | tuple.remote_address));
+    hash = mix64(hash ^ ((uint64_t{tuple.local_port} << 48) | (uint64_t{tuple.remote_port} << 32) |
+                         peer_isn.raw_value()));
+    hash = mix64(hash ^ period);
+    return WrappingInt32{(uint32_t(period % 32) << 27) | uint32_t(hash & 0x07ff'ffff)};
+}
+
+//! \returns `true` if `cookie` was issued for this four-tuple and peer ISN during the current or previous period
+bool TCPListener::_syn_cookie_valid(const TCPFourTuple &tuple,
+                                    const WrappingInt32 peer_isn,
+                                    const WrappingInt32 cookie) const {
+    const uint64_t period = _timers.now() / SYN_COOKIE_PERIOD;
+    for (uint64_t age = 0; age <= min(period, uint64_t{1}); age++) {
+        if (_syn_cookie(tuple, peer_isn, period - age) == cookie) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t TCPListener::_window_size() const { return min(_cfg.recv_capacity, size_t{numeric_limits<uint16_t>::max()}); }
+
+//! \returns the TCP Fast Open cookie for the peer: a keyed hash of its address
+string TCPListener::_fast_open_cookie(const TCPFourTuple &tuple) const {
+    uint64_t hash = mix64(mix64(_cookie_secret + 1) ^ tuple.remote_address);
+    string cookie;
+    for (size_t i = 0; i < sizeof(hash); i++, hash >>= 8) {
+        cookie.push_back(static_cast<char>(hash & 0xff));
+    }
+    return cookie;
+}
+
+void TCPListener::_send_syn_ack(const TCPFourTuple &tuple,
+                                const WrappingInt32 isn,
+                                const WrappingInt32 peer_isn,
+                                const bool send_fast_open_cookie) {
+    TCPSegment segment;
+    TCPHeader &header = segment.header();
+    header.syn = true;
+    header.ack = true;
+    header.seqno = isn;
+    header.ackno = peer_isn + 1;
+    header.win = _window_size();
+    if (send_fast_open_cookie) {
+        header.fast_open_cookie = _fast_open_cookie(tuple);
+    }
+    _segments_out.emplace(tuple, segment);
+}
+
+void TCPListener::_send_rst(const TCPFourTuple &tuple, const WrappingInt32 seqno) {
+    TCPSegment segment;
+    segment.header().rst = true;
+    segment.header().seqno = seqno;
+    _segments_out.emplace(tuple, segment);
+}
+
+//! Bring a connection's clock up to date with the listener's
+void TCPListener::_catch_up(EstablishedConnection &established) {
+    if (_timers.now() > established.last_tick) {
+        established.connection.tick(_timers.now() - established.last_tick);
+        established.last_tick = _timers.now();
+    }
+}
+
+//! Collect a connection's outbound segments and schedule its next timer event
+void TCPListener::_after_event(const TCPFourTuple &tuple, EstablishedConnection &established) {
+    TCPConnection &connection = established.connection;
+    auto &queue = connection.segments_out();
+    if (_fast_open_pending.count(tuple) != 0 and connection.state() != TCPState::State::SYN_RCVD) {
+        _fast_open_pending.erase(tuple);  // the handshake finished (or the connection ended)
+    }
+    while (not queue.empty()) {
+        _segments_out.emplace(tuple, move(queue.front()));
+        queue.pop();
+    }
+
+    const optional<size_t> next_event = connection.time_until_next_event();
+    if (not next_event.has_value()) {
+        if (established.timer.has_value()) {
+            _timers.cancel(established.timer.value());
+            established.timer.reset();
+        }
+    } else if (established.timer.has_value()) {
+        _timers.reschedule(established.timer.value(), next_event.value());
+    } else {
+        established.timer = _timers.schedule(next_event.value(), tuple);
+    }
+
+    if (connection.in_time_wait() and connection.inbound_stream().buffer_empty()) {
+        _enter_time_wait(tuple, established);
+    } else if (not connection.active() or connection.in_time_wait()) {
+        _finished.insert(tuple);
+    }
+}
+
+//! Replace a connection in TIME_WAIT by a TimeWaitConnection (which takes over its timer)
+//! \note Destroys the connection, so `established` is invalid afterwards.
+void TCPListener::_enter_time_wait(const TCPFourTuple &tuple, EstablishedConnection &established) {
+    TCPConnection &connection = established.connection;
+    const Timers::Handle timer = established.timer.has_value()
+                                     ? established.timer.value()
+                                     : _timers.schedule(connection.time_until_next_event().value_or(0), tuple);
+    _time_wait.emplace(tuple, TimeWaitConnection{connection.next_seqno(), connection.ackno().value(), timer});
+    connection.stop_lingering();
+    _connections.erase(tuple);
+}
+
+//! \details Behaves like the lingering TCPConnection would have: any segment
+//! restarts the timer, and segments that occupy sequence space are acknowledged.
+//! \returns `false` if the segment is a SYN that should open a new connection
+//! in place of the one in TIME_WAIT (because its sequence number is later)
+bool TCPListener::_time_wait_segment_received(const TCPFourTuple &tuple, const TCPSegment &seg) {
+    const auto it = _time_wait.find(tuple);
+    TimeWaitConnection &time_wait = it->second;
+    const TCPHeader &header = seg.header();
+
+    if (header.rst or (header.syn and not header.ack and header.seqno - time_wait.ackno > 0)) {
+        _timers.cancel(time_wait.timer);
+        _time_wait.erase(it);
+        return header.rst;
+    }
+
+    _timers.reschedule(time_wait.timer, 10 * _cfg.rt_timeout);
+    if (seg.length_in_sequence_space() > 0 or header.seqno == time_wait.ackno - 1) {
+        TCPSegment ack;
+        ack.header().ack = true;
+        ack.header().seqno = time_wait.seqno;
+        ack.header().ackno = time_wait.ackno;
+        ack.header().win = _window_size();
+        _segments_out.emplace(tuple, ack);
+    }
+    return true;
+}
+
+//! \details The new TCPConnection is brought up to date by replaying the
+//! handshake: it is handed the peer's SYN (its SYN/ACK, which the listener has
+//! already sent, is discarded) and then the peer's ACK.
+void TCPListener::_establish(const TCPFourTuple &tuple, const WrappingInt32 isn, const TCPSegment &ack) {
+    TCPConfig cfg = _cfg;
+    cfg.fixed_isn = isn;
+
+    EstablishedConnection &established =
+        _connections.emplace(piecewise_construct, forward_as_tuple(tuple), forward_as_tuple(cfg, _timers.now()))
+            .first->second;
+    TCPConnection &connection = established.connection;
+
+    TCPSegment syn;
+    syn.header().syn = true;
+    syn.header().seqno = ack.header().seqno - 1;
+    connection.segment_received(syn);
+    while (not connection.segments_out().empty()) {
+        connection.segments_out().pop();
+    }
+
+    connection.segment_received(ack);
+    _after_event(tuple, established);
+    _accept_queue.push(tuple);
+}
+
+//! \details Unlike _establish(), the connection is created directly from the
+//! peer's SYN, so it sends the SYN/ACK itself (acknowledging the SYN's data).
+void TCPListener::_establish_fast_open(const TCPFourTuple &tuple, const TCPSegment &syn) {
+    EstablishedConnection &established =
+        _connections.emplace(piecewise_construct, forward_as_tuple(tuple), forward_as_tuple(_cfg, _timers.now()))
+            .first->second;
+    _fast_open_pending.insert(tuple);
+    established.connection.segment_received(syn);
+    _after_event(tuple, established);
+    _accept_queue.push(tuple);
+}
+
+void TCPListener::_syn_received(const TCPFourTuple &tuple, const TCPSegment &seg) {
+    const WrappingInt32 peer_isn = seg.header().seqno;
+    const optional<string> &fast_open_cookie = seg.header().fast_open_cookie;
+    const bool fast_open = _listener_cfg.fast_open and fast_open_cookie.has_value();
+
+    // a retransmitted SYN for a handshake that is already under way
+    const auto it = _syn_backlog.find(tuple);
+    if (it != _syn_backlog.end()) {
+        if (it->second.peer_isn == peer_isn) {
+            _send_syn_ack(tuple, it->second.isn, peer_isn, it->second.send_fast_open_cookie);
+        }
+        return;
+    }
+
+    // a valid TCP Fast Open cookie skips the handshake
+    if (fast_open and not fast_open_cookie->empty() and fast_open_cookie == _fast_open_cookie(tuple) and
+        _accept_queue.size() < _listener_cfg.accept_backlog and
+        _fast_open_pending.size() < _listener_cfg.fast_open_backlog) {
+        _establish_fast_open(tuple, seg);
+        return;
+    }
+
+    if (_syn_backlog.size() < _listener_cfg.syn_backlog) {
+        const WrappingInt32 isn{static_cast<uint32_t>(_rand())};
+        const Timers::Handle timer = _timers.schedule(_cfg.rt_timeout, tuple);
+        _syn_backlog.emplace(tuple, HalfOpenConnection{isn, peer_isn, _cfg.rt_timeout, timer, 0, fast_open});
+        _send_syn_ack(tuple, isn, peer_isn, fast_open);
+    } else if (_listener_cfg.syn_cookies) {
+        _send_syn_ack(tuple, _syn_cookie(tuple, peer_isn, _timers.now() / SYN_COOKIE_PERIOD), peer_isn, fast_open);
+        _syn_cookies_sent++;
+    }
+}
+
+void TCPListener::_ack_received(const TCPFourTuple &tuple, const TCPSegment &seg) {
+    const TCPHeader &header = seg.header();
+    const WrappingInt32 peer_isn = header.seqno - 1;
+
+    // is this the end of a handshake in the SYN backlog, or one answered with a SYN cookie?
+    const auto it = _syn_backlog.find(tuple);
+    WrappingInt32 isn = header.ackno - 1;
+    bool valid;
+    if (it != _syn_backlog.end()) {
+        valid = it->second.isn == isn and it->second.peer_isn == peer_isn;
+    } else {
+        valid = _listener_cfg.syn_cookies and _syn_cookie_valid(tuple, peer_isn, isn);
+    }
+
+    if (not valid) {
+        _send_rst(tuple, header.ackno);
+        return;
+    }
+
+    // With a full accept queue, drop the ACK. If the handshake is in the
+    // backlog, the retransmitted SYN/ACK will prompt the peer to try again.
+    if (_accept_queue.size() >= _listener_cfg.accept_backlog) {
+        return;
+    }
+
+    if (it != _syn_backlog.end()) {
+        _timers.cancel(it->second.timer);
+        _syn_backlog.erase(it);
+    }
+    _establish(tuple, isn, seg);
+}
+
+//! \param[in] tuple identifies the connection (from the listener's point of view)
+//! \param[in] seg the segment that was received
+void TCPListener::segment_received(const TCPFourTuple &tuple, const TCPSegment &seg) {
+    const auto connection = _connections.find(tuple);
+    if (connection != _connections.end()) {
+        _catch_up(connection->second);
+        connection->second.connection.segment_received(seg);
+        _after_event(tuple, connection->second);
+        return;
+    }
+
+    if (_time_wait.count(tuple) and _time_wait_segment_received(tuple, seg)) {
+        return;
+    }
+
+    const TCPHeader &header = seg.header();
+    if (header.rst) {
+        const auto half_open = _syn_backlog.find(tuple);
+        if (half_open != _syn_backlog.end()) {
+            _timers.cancel(half_open->second.timer);
+            _syn_backlog.erase(half_open);
+        }
+    } else if (header.syn and not header.ack) {
+        _syn_received(tuple, seg);
+    } else if (header.ack and not header.syn) {
+        _ack_received(tuple, seg);
+    }
+}
+
+void TCPListener::_retransmit_syn_ack(const TCPFourTuple &tuple, HalfOpenConnection &half_open) {
+    if (half_open.retransmissions >= TCPConfig::MAX_RETX_ATTEMPTS) {
+        _syn_backlog.erase(tuple);
+        return;
+    }
+    half_open.retransmissions++;
+    half_open.rto *= 2;
+    half_open.timer = _timers.schedule(half_open.rto, tuple);
+    _send_syn_ack(tuple, half_open.isn, half_open.peer_isn, half_open.send_fast_open_cookie);
+}
+
+void TCPListener::_reap_connections() {
+    for (auto it = _finished.begin(); it != _finished.end(); /* nop */) {
+        const TCPFourTuple tuple = *it;
+        const auto connection = _connections.find(tuple);
+        if (connection != _connections.end() and not connection->second.connection.inbound_stream().buffer_empty()) {
+            ++it;
+            continue;
+        }
+
+        it = _finished.erase(it);
+        if (connection == _connections.end()) {
+            continue;
+        }
+        if (connection->second.connection.in_time_wait()) {
+            _enter_time_wait(tuple, connection->second);
+        } else {
+            if (connection->second.timer.has_value()) {
+                _timers.cancel(connection->second.timer.value());
+            }
+            _fast_open_pending.erase(tuple);
+            _connections.erase(connection);
+        }
+    }
+}
+
+//! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
+//! \details Only the half-open and established connections whose timers expire are visited.
+void TCPListener::tick(const size_t ms_since_last_tick) {
+    for (const TCPFourTuple &tuple : _timers.advance(ms_since_last_tick)) {
+        const auto half_open = _syn_backlog.find(tuple);
+        if (half_open != _syn_backlog.end()) {
+            _retransmit_syn_ack(tuple, half_open->second);
+            continue;
+        }
+        if (_time_wait.erase(tuple)) {
+            continue;
+        }
+
+        EstablishedConnection &established = _connections.at(tuple);
+        established.timer.reset();
+        _catch_up(established);
+        _after_event(tuple, established);
+    }
+
+    _reap_connections();
+}
+
+//! \details Connections that were reset before being accepted are skipped.
+optional<TCPFourTuple> TCPListener::accept() {
+    while (not _accept_queue.empty()) {
+        const TCPFourTuple tuple = _accept_queue.front();
+        _accept_queue.pop();
+        if (_connections.count(tuple)) {
+            return tuple;
+        }
+    }
+    return {};
+}
+
+size_t TCPListener::write(const TCPFourTuple &tuple, const string &data) {
+    EstablishedConnection &established = _connections.at(tuple);
+    _catch_up(established);
+    const size_t ret = established.connection.write(data);
+    _after_event(tuple, established);
+    return ret;
+}
+
+void TCPListener::end_input_stream(const TCPFourTuple &tuple) {
+    EstablishedConnection &established = _connections.at(tuple);
+    _catch_up(established);
+    established.connection.end_input_stream();
+    _after_event(tuple, established);
+}
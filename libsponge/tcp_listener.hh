@@ -0,0 +1,218 @@
+#ifndef SPONGE_LIBSPONGE_TCP_LISTENER_HH
+#define SPONGE_LIBSPONGE_TCP_LISTENER_HH
+
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_four_tuple.hh"
+#include "tcp_segment.hh"
+#include "timer_wheel.hh"
+
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+//! \brief A listening TCP endpoint that accepts any number of connections
+
+//! The TCPListener plays the part of the kernel behind a listening socket.
+//! It answers SYNs, keeps a bounded queue of half-open (SYN_RCVD)
+//! handshakes, and only builds a full TCPConnection (with its byte
+//! streams and reassembler) once the peer's final ACK arrives. Finished
+//! handshakes wait in a bounded accept queue until the owner calls accept().
+//!
+//! When the SYN backlog is full, the listener can fall back to
+//! [SYN cookies](https://cr.yp.to/syncookies.html): the handshake state is
+//! encoded in the ISN of the SYN/ACK, so a flood of SYNs costs no memory.
+class TCPListener {
+  public:
+    //! A segment paired with the connection it belongs to
+    using SegmentOut = std::pair<TCPFourTuple, TCPSegment>;
+
+  private:
+    using Timers = TimerWheel<TCPFourTuple>;
+
+    //! Everything needed to finish a three-way handshake, and nothing more
+    struct HalfOpenConnection {
+        WrappingInt32 isn;             //!< ISN of our SYN/ACK
+        WrappingInt32 peer_isn;        //!< ISN of the peer's SYN
+        size_t rto;                    //!< current SYN/ACK retransmission timeout
+        Timers::Handle timer;          //!< when the SYN/ACK is retransmitted
+        unsigned int retransmissions;  //!< number of SYN/ACK retransmissions so far
+        bool send_fast_open_cookie;    //!< should the SYN/ACK carry a TCP Fast Open cookie?
+    };
+
+    //! An established connection, which is only ticked when its next timer is due
+    struct EstablishedConnection {
+        TCPConnection connection;
+        uint64_t last_tick;                   //!< time on the listener's clock when `connection` was last ticked
+        std::optional<Timers::Handle> timer;  //!< the connection's next timer event, if any
+
+        EstablishedConnection(const TCPConfig &cfg, const uint64_t now) : connection(cfg), last_tick(now), timer() {}
+    };
+
+    //! What is left of a connection in TIME_WAIT: enough to acknowledge a retransmitted FIN
+    struct TimeWaitConnection {
+        WrappingInt32 seqno;   //!< our next sequence number (just past our FIN)
+        WrappingInt32 ackno;   //!< the peer's next sequence number (just past its FIN)
+        Timers::Handle timer;  //!< when the record is discarded
+    };
+
+    //! SYN cookies are valid for this long (in milliseconds) after being issued, and at most twice as long
+    static constexpr uint64_t SYN_COOKIE_PERIOD = 64 * 1000;
+
+    TCPConfig _cfg;
+    TCPListenerConfig _listener_cfg;
+
+    //! Deadlines of half-open and established connections
+    Timers _timers{};
+
+    //! Half-open connections, keyed by four-tuple
+    std::unordered_map<TCPFourTuple, HalfOpenConnection, TCPFourTupleHash> _syn_backlog{};
+
+    //! Established connections, accepted or not
+    std::unordered_map<TCPFourTuple, EstablishedConnection, TCPFourTupleHash> _connections{};
+
+    //! Connections that are no longer active, or are in TIME_WAIT, to be discarded (or collapsed
+    //! into a TimeWaitConnection) once their inbound streams are drained
+    std::unordered_set<TCPFourTuple, TCPFourTupleHash> _finished{};
+
+    //! Connections in TIME_WAIT, keyed by four-tuple
+    std::unordered_map<TCPFourTuple, TimeWaitConnection, TCPFourTupleHash> _time_wait{};
+
+    //! Connections accepted by TCP Fast Open that are still waiting for the peer to acknowledge our SYN
+    std::unordered_set<TCPFourTuple, TCPFourTupleHash> _fast_open_pending{};
+
+    //! Established connections that have not yet been handed to the owner
+    std::queue<TCPFourTuple> _accept_queue{};
+
+    //! outbound queue of segments that the TCPListener wants sent
+    std::queue<SegmentOut> _segments_out{};
+
+    //! Source of ISNs and of the SYN cookie secret
+    std::mt19937 _rand;
+
+    //! Key mixed into every SYN cookie and TCP Fast Open cookie
+    uint64_t _cookie_secret;
+
+    //! Number of SYNs answered with a cookie instead of a backlog entry
+    uint64_t _syn_cookies_sent{0};
+
+    void _syn_received(const TCPFourTuple &tuple, const TCPSegment &seg);
+    void _ack_received(const TCPFourTuple &tuple, const TCPSegment &seg);
+    uint16_t _window_size() const;
+    void _send_syn_ack(const TCPFourTuple &tuple,
+                       const WrappingInt32 isn,
+                       const WrappingInt32 peer_isn,
+                       const bool send_fast_open_cookie);
+    void _send_rst(const TCPFourTuple &tuple, const WrappingInt32 seqno);
+    void _establish(const TCPFourTuple &tuple, const WrappingInt32 isn, const TCPSegment &ack);
+    void _establish_fast_open(const TCPFourTuple &tuple, const TCPSegment &syn);
+    void _catch_up(EstablishedConnection &established);
+    void _after_event(const TCPFourTuple &tuple, EstablishedConnection &established);
+    void _retransmit_syn_ack(const TCPFourTuple &tuple, HalfOpenConnection &half_open);
+    bool _time_wait_segment_received(const TCPFourTuple &tuple, const TCPSegment &seg);
+    void _enter_time_wait(const TCPFourTuple &tuple, EstablishedConnection &established);
+    void _reap_connections();
+
+    WrappingInt32 _syn_cookie(const TCPFourTuple &tuple, const WrappingInt32 peer_isn, const uint64_t period) const;
+    bool _syn_cookie_valid(const TCPFourTuple &tuple, const WrappingInt32 peer_isn, const WrappingInt32 cookie) const;
+    std::string _fast_open_cookie(const TCPFourTuple &tuple) const;
+
+  public:
+    //! \brief Construct a listener whose connections will use configuration `cfg`
+    explicit TCPListener(const TCPConfig &cfg, const TCPListenerConfig &listener_cfg = {});
+
+    //! \name Methods for the owner or operating system to call
+    //!@{
+
+    //! \brief Called when a new segment addressed to the listening port has been received
+    void segment_received(const TCPFourTuple &tuple, const TCPSegment &seg);
+
+    //! \brief Called periodically when time elapses
+    void tick(const size_t ms_since_last_tick);
+
+    //! \brief Segments (for any connection) that the TCPListener has enqueued for transmission
+    std::queue<SegmentOut> &segments_out() { return _segments_out; }
+    //!@}
+
+    //! \name "Socket" interface for the owner
+    //!@{
+
+    //! \brief Take the oldest established connection off the accept queue
+    //! \returns the connection's four-tuple, or empty if no connection is waiting
+    std::optional<TCPFourTuple> accept();
+
+    //! \brief Write data to a connection's outbound byte stream, and send it over TCP if possible
+    size_t write(const TCPFourTuple &tuple, const std::string &data);
+
+    //! \brief Shut down a connection's outbound byte stream
+    void end_input_stream(const TCPFourTuple &tuple);
+
+    //! \brief The inbound byte stream of a connection
+    ByteStream &inbound_stream(const TCPFourTuple &tuple) { return _connections.at(tuple).connection.inbound_stream(); }
+
+    //! \brief Access a connection (e.g. to check its state)
+    const TCPConnection &connection(const TCPFourTuple &tuple) const { return _connections.at(tuple).connection; }
+
+    //! \brief Is there a connection with this four-tuple?
+    bool has_connection(const TCPFourTuple &tuple) const { return _connections.count(tuple) != 0; }
+    //!@}
+
+    //! \name Accessors
+    //!@{
+
+    //! \brief Number of half-open connections in the SYN backlog
+    size_t syn_backlog_size() const { return _syn_backlog.size(); }
+
+    //! \brief Number of established connections waiting to be accepted
+    size_t accept_queue_size() const { return _accept_queue.size(); }
+
+    //! \brief Number of established connections (accepted or not)
+    size_t connection_count() const { return _connections.size(); }
+
+    //! \brief Number of connections in TIME_WAIT
+    size_t time_wait_count() const { return _time_wait.size(); }
+
+    //! \brief Number of SYNs that have been answered with a SYN cookie
+    uint64_t syn_cookies_sent() const { return _syn_cookies_sent; }
+
+    //! \brief Number of connections accepted by TCP Fast Open whose handshake has not finished
+    size_t fast_open_pending() const { return _fast_open_pending.size(); }
+    //!@}
+};
+
+//! \class TCPListener
+//! Connections stay owned by the TCPListener after they are accepted, so that
+//! it can keep feeding them segments and timer ticks. The owner drives all of
+//! them through segment_received(), tick() and segments_out(). A connection is
+//! discarded, and references to it become invalid, during the first tick()
+//! after it is no longer active and its inbound stream has been read to the end.
+//!
+//! The listener keeps every deadline (SYN/ACK retransmissions, and each
+//! connection's TCPConnection::time_until_next_event()) in a TimerWheel, so a
+//! tick() only visits the connections whose timers expire. The others are
+//! brought up to date when they next receive a segment or a timer event, so
+//! their TCPConnection::time_since_last_segment_received() may lag behind.
+//!
+//! With TCPListenerConfig::fast_open, the listener also implements the server
+//! side of [TCP Fast Open](\ref rfc::rfc7413). A SYN that asks for a cookie
+//! gets one in the SYN/ACK (a keyed hash of the peer's address). A SYN that
+//! presents a valid cookie creates the connection at once: its data goes
+//! straight to the inbound stream, and the connection joins the accept queue
+//! before the handshake completes. If the cookie is invalid, the accept queue
+//! is full, or TCPListenerConfig::fast_open_backlog connections are already
+//! waiting for their handshakes to finish, the data is ignored, and the peer
+//! sends it again after the handshake. Options with a cookie of an invalid
+//! length are ignored when the segment is parsed.
+//!
+//! A connection that reaches TIME_WAIT, once its inbound stream has been
+//! read to the end, is replaced by a small TimeWaitConnection record, and
+//! its byte streams and reassembler are freed. The record acknowledges the
+//! peer's retransmitted FINs until it expires, and a new SYN from the same
+//! peer (with a later sequence number) takes its place.
+
+#endif  // SPONGE_LIBSPONGE_TCP_LISTENER_HH
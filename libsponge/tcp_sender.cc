@@ -18,12 +18,17 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] fast_open_cookie the TCP Fast Open cookie to put in the SYN (empty to request one), if set
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const std::optional<std::string> &fast_open_cookie)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
     , _curr_rto(retx_timeout)
     , _curr_time(retx_timeout)
-    , _stream(capacity) {}
+    , _stream(capacity)
+    , _fast_open_cookie(fast_open_cookie) {}
 
 uint64_t TCPSender::bytes_in_flight() const { return _bytes_in_flight; }
 
@@ -39,12 +44,18 @@ void TCPSender::fill_window() {
         header.seqno = wrap(_next_seqno, _isn);
         if (_next_seqno == 0) {
             header.syn = true;
+            header.fast_open_cookie = _fast_open_cookie;
             bytes_sent += 1;
         } else if (_stream.buffer_empty() && !_stream.input_ended())
             break;
 
         len = _window_size - bytes_sent;
-        payload = Buffer(move(_stream.read(min(TCPConfig::MAX_PAYLOAD_SIZE, len))));
+        // with a TCP Fast Open cookie, the SYN can carry data before the peer has advertised a window
+        if (header.syn && _fast_open_cookie.has_value() && !_fast_open_cookie->empty())
+            len = TCPConfig::MAX_PAYLOAD_SIZE;
+        // copy the payload into a pooled slab, leaving room to prepend the headers when it is sent
+        payload = _buffer_pool.take(_stream.peek_view(min(TCPConfig::MAX_PAYLOAD_SIZE, len)));
+        _stream.pop_output(payload.size());
         bytes_sent += payload.size();
 
         if (bytes_sent < _window_size && _stream.buffer_empty() && _stream.input_ended()) {
@@ -53,6 +64,8 @@ void TCPSender::fill_window() {
             _fin_sent = true;
         }
 
+        // retransmissions share the first transmission's serialized header
+        segment.cache_serialization();
         _pend_list[_next_seqno] = segment;
         _segments_out.push(segment);
         _next_seqno += segment.length_in_sequence_space();
@@ -62,7 +75,7 @@ void TCPSender::fill_window() {
         if (_stream.buffer_empty())
             break;
     }
-    _window_size -= bytes_sent;
+    _window_size = bytes_sent < _window_size ? _window_size - bytes_sent : 0;
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
@@ -94,6 +107,19 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     }
     _pend_list.erase(_pend_list.begin(), it);
 
+    // If the peer acknowledged a SYN but not the data it carried (a TCP Fast Open
+    // cookie was refused), send the data again right away, in a segment of its own.
+    if (it != _pend_list.end() && it->second.header().syn && ackno_abs > it->first) {
+        TCPSegment data = it->second;
+        data.header().syn = false;
+        data.header().fast_open_cookie.reset();
+        data.header().seqno = wrap(ackno_abs, _isn);
+        data.payload().remove_prefix(ackno_abs - it->first - 1);
+        _pend_list.erase(it);
+        _pend_list[ackno_abs] = data;
+        _segments_out.push(data);
+    }
+
     _window_size = ackno_abs + new_window_size > _next_seqno ? ackno_abs + new_window_size - _next_seqno : 0;
     if (ackno_abs + new_window_size > _next_seqno)
         fill_window();
@@ -125,6 +151,12 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
 
 unsigned int TCPSender::consecutive_retransmissions() const { return _consecutive_retrans_time; }
 
+optional<size_t> TCPSender::time_until_timeout() const {
+    if (_time_stop)
+        return nullopt;
+    return _curr_time;
+}
+
 void TCPSender::send_empty_segment() {
     TCPSegment segment;
     segment.header().seqno = next_seqno();
@@ -8,6 +8,7 @@
 
 #include <functional>
 #include <map>
+#include <optional>
 #include <queue>
 
 //! \brief The "sender" part of a TCP implementation.
@@ -45,11 +46,18 @@ class TCPSender {
     bool _fin_sent = false;
     uint16_t _recv_window_size{1};
 
+    //! TCP Fast Open cookie for the SYN (empty to request one), if TCP Fast Open is in use
+    std::optional<std::string> _fast_open_cookie;
+
+    //! slabs for outgoing payloads
+    BufferPool _buffer_pool{};
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const std::optional<std::string> &fast_open_cookie = {});
 
     //! \name "Input" interface for the writer
     //!@{
@@ -84,6 +92,9 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Milliseconds until the retransmission timer expires, or empty if it is not running
+    std::optional<size_t> time_until_timeout() const;
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
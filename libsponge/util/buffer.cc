@@ -1,15 +1,97 @@
 #include "buffer.hh"
 
+#include <cstring>
+
 using namespace std;
 
+Buffer::Buffer(const size_t headroom, const string_view data)
+    : _storage(new BufferStorage{string(headroom + data.size(), 0), headroom, {1}, THREAD_SAFE_BY_DEFAULT})
+    , _starting_offset(headroom) {
+    memcpy(_storage->bytes.data() + headroom, data.data(), data.size());
+}
+
+Buffer Buffer::thread_safe() const {
+    if (not _storage or _storage->thread_safe) {
+        return *this;
+    }
+    if (_unique()) {
+        // no other Buffer can be touching the count
+        _storage->thread_safe = true;
+        return *this;
+    }
+    Buffer ret{0, str()};
+    ret._storage->thread_safe = true;
+    return ret;
+}
+
 void Buffer::remove_prefix(const size_t n) {
     if (n > str().size()) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
-        _storage.reset();
+    if (_storage and _starting_offset == _storage->bytes.size()) {
+        _release(_storage);
+        _storage = nullptr;
+        _starting_offset = 0;
+    }
+}
+
+bool Buffer::prepend(const string_view header) {
+    if (not _storage or _storage->headroom != _starting_offset or header.size() > _starting_offset) {
+        return false;
+    }
+    _starting_offset -= header.size();
+    _storage->headroom = _starting_offset;
+    memcpy(_storage->bytes.data() + _starting_offset, header.data(), header.size());
+    return true;
+}
+
+BufferStorage *BufferPool::_free_slab() {
+    // look at a few slabs, starting where the last search left off; slabs are mostly released in
+    // the order they were taken (as segments are acknowledged), so a free one is usually close
+    constexpr size_t MAX_PROBES = 8;
+    for (size_t probe = 0; probe < min(MAX_PROBES, _slabs.size()); probe++) {
+        const size_t index = (_next + probe) % _slabs.size();
+        if (_slabs[index]._unique()) {
+            _next = (index + 1) % _slabs.size();
+            return _slabs[index]._storage;
+        }
+    }
+
+    if (_slabs.size() >= MAX_SLABS) {
+        return nullptr;
+    }
+    _slabs.push_back(Buffer{new BufferStorage{string(), 0, {1}, _thread_safe}});
+    _slabs.back()._storage->bytes.reserve(SLAB_SIZE);
+    _next = 0;
+    return _slabs.back()._storage;
+}
+
+void BufferPool::_fill(BufferStorage *storage, const string_view data) {
+    // a slab's old contents need not be cleared, and resizing it to the same size (as for a
+    // steady stream of full-sized segments) writes nothing
+    storage->bytes.resize(HEADROOM + data.size());
+    storage->headroom = HEADROOM;
+    storage->checksum = InternetChecksum{};
+    storage->checksum.add_copy(storage->bytes.data() + HEADROOM, data);
+    storage->checksum_offset = HEADROOM;
+}
+
+Buffer BufferPool::take(const string_view data) {
+    if (data.empty()) {
+        return {};
     }
+    BufferStorage *slab = HEADROOM + data.size() > SLAB_SIZE ? nullptr : _free_slab();
+    if (not slab) {
+        auto storage = new BufferStorage{string(), 0, {1}, _thread_safe};
+        _fill(storage, data);
+        return Buffer(storage);
+    }
+
+    // reuses the slab's memory: the capacity never drops below SLAB_SIZE
+    _fill(slab, data);
+    Buffer::_acquire(slab);
+    return Buffer(slab);
 }
 
 void BufferList::append(const BufferList &other) {
@@ -18,6 +100,20 @@ void BufferList::append(const BufferList &other) {
     }
 }
 
+void BufferList::prepend(const string_view header) {
+    if (_buffers.empty() or not _buffers.front().prepend(header)) {
+        _buffers.push_front(Buffer(string(header)));
+    }
+}
+
+BufferList BufferList::thread_safe() const {
+    BufferList ret;
+    for (const auto &buf : _buffers) {
+        ret._buffers.push_back(buf.thread_safe());
+    }
+    return ret;
+}
+
 BufferList::operator Buffer() const {
     switch (_buffers.size()) {
         case 0:
@@ -94,9 +190,8 @@ size_t BufferViewList::size() const {
     return ret;
 }
 
-vector<iovec> BufferViewList::as_iovecs() const {
-    vector<iovec> ret;
-    ret.reserve(_views.size());
+SmallVector<iovec, BufferList::INLINE_BUFFERS> BufferViewList::as_iovecs() const {
+    SmallVector<iovec, BufferList::INLINE_BUFFERS> ret;
     for (const auto &x : _views) {
         ret.push_back({const_cast<char *>(x.data()), x.size()});
     }
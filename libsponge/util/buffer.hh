@@ -1,27 +1,133 @@
 #ifndef SPONGE_LIBSPONGE_BUFFER_HH
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
+#include "small_vector.hh"
+#include "util.hh"
+
 #include <algorithm>
-#include <deque>
-#include <memory>
+#include <atomic>
 #include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <sys/uio.h>
 #include <vector>
 
+//! \brief The bytes shared by copies of a Buffer, and how many copies there are
+//! \details The first `headroom` bytes hold no data. A Buffer that starts right after them can
+//! claim some of them with Buffer::prepend(), so that a header can be written in front of a
+//! payload without copying the payload.
+//!
+//! Most Buffers are copied and destroyed on a single thread (e.g. the TCP thread), so unless
+//! `thread_safe` is set, `refs` is updated with plain loads and stores instead of atomic
+//! read-modify-write operations. `thread_safe` only changes while a single Buffer refers to the storage.
+//!
+//! A BufferPool checksums the data as it copies it in; the sum covers `bytes` from `checksum_offset` on.
+struct BufferStorage {
+    std::string bytes;                          //!< the headroom, followed by the data
+    size_t headroom;                            //!< number of unclaimed bytes at the front of `bytes`
+    std::atomic<size_t> refs;                   //!< number of Buffers that refer to the storage
+    bool thread_safe;                           //!< may the Buffers of the storage be on different threads?
+    InternetChecksum checksum{};                //!< the sum of the data, if it was computed
+    size_t checksum_offset{std::string::npos};  //!< where the summed data starts (npos if not summed)
+};
+
 //! \brief A reference-counted read-only string that can discard bytes from the front
+//! \note Copies of a Buffer may only be used from different threads if it was made with thread_safe()
+//! (or, if sponge is built with `SPONGE_ATOMIC_BUFFERS`, always).
 class Buffer {
   private:
-    std::shared_ptr<std::string> _storage{};
+    BufferStorage *_storage{};
     size_t _starting_offset{};
 
+    friend class BufferPool;
+
+    //! \brief Construct a view of all the data in `storage`, taking over a reference to it
+    explicit Buffer(BufferStorage *storage) : _storage(storage), _starting_offset(storage->headroom) {}
+
+    static void _acquire(BufferStorage *storage) {
+        if (not storage) {
+            return;
+        }
+        if (storage->thread_safe) {
+            storage->refs.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            storage->refs.store(storage->refs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    static void _release(BufferStorage *storage) {
+        if (not storage) {
+            return;
+        }
+        size_t remaining;
+        if (storage->thread_safe) {
+            remaining = storage->refs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        } else {
+            remaining = storage->refs.load(std::memory_order_relaxed) - 1;
+            storage->refs.store(remaining, std::memory_order_relaxed);
+        }
+        if (remaining == 0) {
+            delete storage;
+        }
+    }
+
+    //! Is this the only Buffer that refers to its storage?
+    bool _unique() const { return _storage and _storage->refs.load(std::memory_order_acquire) == 1; }
+
   public:
+#ifdef SPONGE_ATOMIC_BUFFERS
+    static constexpr bool THREAD_SAFE_BY_DEFAULT = true;  //!< Are new Buffers thread-safe?
+#else
+    static constexpr bool THREAD_SAFE_BY_DEFAULT = false;  //!< Are new Buffers thread-safe?
+#endif
+
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept
+        : _storage(new BufferStorage{std::move(str), 0, {1}, THREAD_SAFE_BY_DEFAULT}) {}
+
+    //! \brief Construct by copying `data`, leaving room for `headroom` bytes of headers in front of it
+    Buffer(const size_t headroom, const std::string_view data);
+
+    //! \name Copying and moving adjust the reference count
+    //!@{
+    Buffer(const Buffer &other) : _storage(other._storage), _starting_offset(other._starting_offset) {
+        _acquire(_storage);
+    }
+
+    Buffer(Buffer &&other) noexcept : _storage(other._storage), _starting_offset(other._starting_offset) {
+        other._storage = nullptr;
+        other._starting_offset = 0;
+    }
+
+    Buffer &operator=(const Buffer &other) {
+        _acquire(other._storage);
+        _release(_storage);
+        _storage = other._storage;
+        _starting_offset = other._starting_offset;
+        return *this;
+    }
+
+    Buffer &operator=(Buffer &&other) noexcept {
+        if (this != &other) {
+            _release(_storage);
+            _storage = other._storage;
+            _starting_offset = other._starting_offset;
+            other._storage = nullptr;
+            other._starting_offset = 0;
+        }
+        return *this;
+    }
+
+    ~Buffer() { _release(_storage); }
+    //!@}
+
+    //! \brief A Buffer with the same contents, whose copies may be used and destroyed on any thread
+    //! \note Shares the storage if this is its only Buffer; otherwise the contents are copied.
+    Buffer thread_safe() const;
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +135,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->bytes.data() + _starting_offset, _storage->bytes.size() - _starting_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -38,6 +144,14 @@ class Buffer {
     //! \brief Get character at location `n`
     uint8_t at(const size_t n) const { return str().at(n); }
 
+    //! \brief The checksum of the string, if it was computed as the Buffer was filled (see BufferPool::take)
+    std::optional<InternetChecksum> checksum() const {
+        if (_storage and _storage->checksum_offset == _starting_offset) {
+            return _storage->checksum;
+        }
+        return std::nullopt;
+    }
+
     //! \brief Size of the string
     size_t size() const { return str().size(); }
 
@@ -47,6 +161,47 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Write `header` into the headroom just in front of the string, and extend the string to include it
+    //! \returns `false` (and changes nothing) if there is not enough headroom, or if another copy of
+    //! the Buffer has already claimed the headroom
+    //! \note Other copies of the Buffer are unaffected, since they do not view the headroom.
+    bool prepend(const std::string_view header);
+};
+
+//! \brief A pool of fixed-size slabs for packet payloads, each with headroom for the headers of every layer
+//! \details Buffers taken from the pool share their slab with all their copies, like any Buffer. Once the
+//! last copy is gone, the slab is handed out again by a later take(), so a steady stream of packets
+//! does not allocate. Only the owner's thread may call take(), but the Buffers of a thread-safe pool
+//! may be passed to other threads.
+class BufferPool {
+  public:
+    static constexpr size_t SLAB_SIZE = 2048;  //!< size of each slab, including headroom
+    static constexpr size_t HEADROOM = 128;    //!< room reserved for the TCP, IPv4 and Ethernet headers
+    static constexpr size_t MAX_SLABS = 1024;  //!< beyond this many slabs in use, take() allocates
+
+  private:
+    std::vector<Buffer> _slabs{};  //!< the pool's own reference to each slab
+    size_t _next{0};               //!< where the search for a free slab starts
+    bool _thread_safe;
+
+    //! A slab that no Buffer refers to, or null if none could be found quickly
+    BufferStorage *_free_slab();
+
+    //! Copy `data` into `storage` after HEADROOM bytes, checksumming it on the way
+    static void _fill(BufferStorage *storage, const std::string_view data);
+
+  public:
+    //! \brief Construct an empty pool, whose Buffers may be used on different threads if `thread_safe`
+    explicit BufferPool(const bool thread_safe = Buffer::THREAD_SAFE_BY_DEFAULT) : _thread_safe(thread_safe) {}
+
+    //! \brief A Buffer holding a copy of `data`, with HEADROOM bytes of headroom (unless `data` is empty)
+    //! \details The data is checksummed while it is copied, and the sum kept with it (see Buffer::checksum()).
+    //! \note Falls back to a newly allocated Buffer if `data` does not fit in a slab or no slab is free.
+    Buffer take(const std::string_view data);
+
+    //! \brief Number of slabs the pool has allocated
+    size_t slabs() const { return _slabs.size(); }
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -55,8 +210,12 @@ class Buffer {
 //! encapsulate a TCP payload in a TCPSegment, and then encapsulate
 //! the TCPSegment in an IPv4Datagram) without copying the payload.
 class BufferList {
+  public:
+    //! Number of Buffers held without allocating (enough for a payload and the headers of each layer)
+    static constexpr size_t INLINE_BUFFERS = 4;
+
   private:
-    std::deque<Buffer> _buffers{};
+    SmallVector<Buffer, INLINE_BUFFERS> _buffers{};
 
   public:
     //! \name Constructors
@@ -65,7 +224,7 @@ class BufferList {
     BufferList() = default;
 
     //! \brief Construct from a Buffer
-    BufferList(Buffer buffer) : _buffers{buffer} {}
+    BufferList(Buffer buffer) { _buffers.push_back(std::move(buffer)); }
 
     //! \brief Construct by taking ownership of a std::string
     BufferList(std::string &&str) noexcept {
@@ -75,11 +234,20 @@ class BufferList {
     //!@}
 
     //! \brief Access the underlying queue of Buffers
-    const std::deque<Buffer> &buffers() const { return _buffers; }
+    const SmallVector<Buffer, INLINE_BUFFERS> &buffers() const { return _buffers; }
 
     //! \brief Append a BufferList
     void append(const BufferList &other);
 
+    //! \brief A BufferList with the same contents, whose copies may be used and destroyed on any thread
+    //! \note See Buffer::thread_safe()
+    BufferList thread_safe() const;
+
+    //! \brief Add `header` at the front
+    //! \note Written into the first Buffer's headroom if it has room, which keeps the
+    //! BufferList contiguous; otherwise added as a Buffer of its own.
+    void prepend(const std::string_view header);
+
     //! \brief Transform to a Buffer
     //! \note Throws an exception unless BufferList is contiguous
     operator Buffer() const;
@@ -96,7 +264,7 @@ class BufferList {
 
 //! \brief A non-owning temporary view (similar to std::string_view) of a discontiguous string
 class BufferViewList {
-    std::deque<std::string_view> _views{};
+    SmallVector<std::string_view, BufferList::INLINE_BUFFERS> _views{};
 
   public:
     //! \name Constructors
@@ -121,10 +289,10 @@ class BufferViewList {
     //! \brief Size of the string
     size_t size() const;
 
-    //! \brief Convert to a vector of `iovec` structures
+    //! \brief Convert to a sequence of `iovec` structures, stored inline (e.g. on the stack) for a typical packet
     //! \note used for system calls that write discontiguous buffers,
     //! e.g. [writev(2)](\ref man2::writev) and [sendmsg(2)](\ref man2::sendmsg)
-    std::vector<iovec> as_iovecs() const;
+    SmallVector<iovec, BufferList::INLINE_BUFFERS> as_iovecs() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_BUFFER_HH
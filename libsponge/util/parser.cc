@@ -31,12 +31,7 @@ T NetParser::_parse_int() {
         return 0;
     }
 
-    T ret = 0;
-    for (size_t i = 0; i < len; i++) {
-        ret <<= 8;
-        ret += uint8_t(_buffer.at(i));
-    }
-
+    const T ret = load_big_endian<T>(_buffer.str().data());
     _buffer.remove_prefix(len);
 
     return ret;
@@ -52,11 +47,9 @@ void NetParser::remove_prefix(const size_t n) {
 
 template <typename T>
 void NetUnparser::_unparse_int(string &s, T val) {
-    constexpr size_t len = sizeof(T);
-    for (size_t i = 0; i < len; ++i) {
-        const uint8_t the_byte = (val >> ((len - i - 1) * 8)) & 0xff;
-        s.push_back(the_byte);
-    }
+    char bytes[sizeof(T)];
+    store_big_endian(bytes, val);
+    s.append(bytes, sizeof(T));
 }
 
 uint32_t NetParser::u32() { return _parse_int<uint32_t>(); }
@@ -5,7 +5,9 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 //! The result of parsing or unparsing an IP datagram, TCP segment, Ethernet frame, or ARP message
@@ -22,6 +24,36 @@ enum class ParseResult {
 //! Output a string representation of a ParseResult
 std::string as_string(const ParseResult r);
 
+//! \brief Convert an unsigned integer between host and network (big-endian) byte order
+template <typename T>
+T swap_network_order(const T val) {
+    static_assert(std::is_unsigned_v<T> and sizeof(T) <= 8, "swap_network_order needs an unsigned integer");
+    if constexpr (sizeof(T) == 1 or __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) {
+        return val;
+    } else if constexpr (sizeof(T) == 2) {
+        return __builtin_bswap16(val);
+    } else if constexpr (sizeof(T) == 4) {
+        return __builtin_bswap32(val);
+    } else {
+        return __builtin_bswap64(val);
+    }
+}
+
+//! \brief Read an integer in network byte order from (possibly unaligned) memory, with a single load
+template <typename T>
+T load_big_endian(const char *data) {
+    T val;
+    memcpy(&val, data, sizeof(T));
+    return swap_network_order(val);
+}
+
+//! \brief Write an integer in network byte order to (possibly unaligned) memory, with a single store
+template <typename T>
+void store_big_endian(char *data, const T val) {
+    const T swapped = swap_network_order(val);
+    memcpy(data, &swapped, sizeof(T));
+}
+
 class NetParser {
   private:
     Buffer _buffer;
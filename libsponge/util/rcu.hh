@@ -0,0 +1,165 @@
+#ifndef SPONGE_LIBSPONGE_RCU_HH
+#define SPONGE_LIBSPONGE_RCU_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//! \brief A value that reader threads use without locks while writers replace it (read-copy-update)
+
+//! Writers never change the published value: update() copies it, changes the copy, and publishes
+//! the copy with an atomic pointer swap. A reader pins the value it loads with a ReadGuard, so
+//! readers never block and never see a value that is being changed.
+//!
+//! Replaced values are reclaimed by epoch. A global epoch advances on every update, and each
+//! reader records the epoch it entered at while it holds a guard. A value retired at epoch E
+//! can only still be in use by a reader that entered before E; once no reader is inside an
+//! epoch older than E, the value is freed. Writers never wait for readers either: values still
+//! in use stay on a list, and are freed by a later update() or reclaim().
+//!
+//! Until the first reader is registered, nothing can be reading the value, so update() changes it
+//! in place instead of copying it (e.g. while a large value is first filled in).
+template <typename T>
+class RCU {
+  public:
+    //! \brief The state of one reader thread
+    //! \note A Reader must only be used by one thread at a time, and by one ReadGuard at a time.
+    class Reader {
+        friend class RCU;
+
+        static constexpr size_t CACHE_LINE = 64;
+
+        //! The epoch at which the reader's current guard was taken, or zero outside a guard
+        alignas(CACHE_LINE) std::atomic<uint64_t> _epoch{0};
+    };
+
+    //! \brief Keeps the value it was made with alive, until it is destroyed
+    class ReadGuard {
+        friend class RCU;
+
+        Reader *_reader;
+        const T *_value;
+
+        ReadGuard(Reader &reader, const T *value) : _reader(&reader), _value(value) {}
+
+      public:
+        //! \name Not copyable; moving transfers the pin
+        //!@{
+        ReadGuard(const ReadGuard &other) = delete;
+        ReadGuard &operator=(const ReadGuard &other) = delete;
+        ReadGuard(ReadGuard &&other) noexcept : _reader(other._reader), _value(other._value) {
+            other._reader = nullptr;
+        }
+        ReadGuard &operator=(ReadGuard &&other) = delete;
+        //!@}
+
+        ~ReadGuard() {
+            if (_reader) {
+                _reader->_epoch.store(0, std::memory_order_release);
+            }
+        }
+
+        //! \name The pinned value
+        //!@{
+        const T &operator*() const { return *_value; }
+        const T *operator->() const { return _value; }
+        //!@}
+    };
+
+  private:
+    std::atomic<const T *> _current;
+    std::atomic<uint64_t> _epoch{1};
+
+    //! Serializes writers, and guards the members below
+    std::mutex _writer_mutex{};
+
+    //! Every registered reader
+    std::vector<std::unique_ptr<Reader>> _readers{};
+
+    //! Values that have been replaced but may still be in use, with the epoch they were retired at
+    std::vector<std::pair<uint64_t, std::unique_ptr<const T>>> _retired{};
+
+    //! Free the retired values that no reader can still be using (with `_writer_mutex` held)
+    void _reclaim_locked() {
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        for (const auto &reader : _readers) {
+            const uint64_t epoch = reader->_epoch.load();
+            if (epoch != 0 and epoch < oldest) {
+                oldest = epoch;
+            }
+        }
+
+        size_t kept = 0;
+        for (auto &retired : _retired) {
+            if (retired.first > oldest) {
+                _retired[kept++] = std::move(retired);
+            }
+        }
+        _retired.resize(kept);
+    }
+
+  public:
+    //! \param[in] initial the first published value
+    explicit RCU(std::unique_ptr<T> initial) : _current(initial.release()) {}
+
+    //! \note No reader may hold a guard
+    ~RCU() { delete _current.load(); }
+
+    //! \name Not copyable or movable, since readers refer to it
+    //!@{
+    RCU(const RCU &other) = delete;
+    RCU &operator=(const RCU &other) = delete;
+    //!@}
+
+    //! \brief Register a reader (for the life of the RCU)
+    //! \details From then on, every update() copies the value; so register readers only once they are needed.
+    Reader &add_reader() {
+        const std::lock_guard<std::mutex> lock(_writer_mutex);
+        _readers.push_back(std::make_unique<Reader>());
+        return *_readers.back();
+    }
+
+    //! \brief Pin the current value for `reader`, which must not already hold a guard
+    ReadGuard read(Reader &reader) const {
+        // Announce the epoch before loading the value. A writer that then finds the reader
+        // outside a guard, or inside a newer epoch, swapped the value before this load.
+        reader._epoch.store(_epoch.load());
+        return ReadGuard{reader, _current.load()};
+    }
+
+    //! \brief Publish a copy of the current value, as changed by `change`
+    //! \details If `change` throws, nothing is published. With no reader registered yet, `change` is
+    //! applied to the current value itself, and keeps whatever it changed before throwing.
+    template <typename Change>
+    void update(Change &&change) {
+        const std::lock_guard<std::mutex> lock(_writer_mutex);
+        if (_readers.empty()) {
+            // add_reader() takes the mutex too, so no reader can start until this returns
+            change(*const_cast<T *>(_current.load()));
+            return;
+        }
+
+        auto next = std::make_unique<T>(*_current.load());
+        change(*next);
+
+        std::unique_ptr<const T> previous{_current.exchange(next.release())};
+        const uint64_t retired_at = _epoch.fetch_add(1) + 1;
+        _retired.emplace_back(retired_at, std::move(previous));
+        _reclaim_locked();
+    }
+
+    //! \brief Free the replaced values that no reader is using any more
+    //! \returns The number of replaced values still in use
+    size_t reclaim() {
+        const std::lock_guard<std::mutex> lock(_writer_mutex);
+        _reclaim_locked();
+        return _retired.size();
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_RCU_HH
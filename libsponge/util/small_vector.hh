@@ -0,0 +1,151 @@
+#ifndef SPONGE_LIBSPONGE_SMALL_VECTOR_HH
+#define SPONGE_LIBSPONGE_SMALL_VECTOR_HH
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//! \brief A sequence that stores up to `N` elements inline, and only allocates beyond that
+//! \details Supports adding and removing elements at both ends, as needed by BufferList (which
+//! prepends headers and discards bytes from the front). Elements live in a contiguous range
+//! `[_begin, _end)` of either the inline array or, once more than `N` elements have been held at
+//! once, a heap vector. `T` must be default-constructible; unused slots hold a default `T`.
+template <typename T, size_t N>
+class SmallVector {
+  private:
+    std::array<T, N> _inline{};
+    std::vector<T> _heap{};
+    size_t _begin{0};
+    size_t _end{0};
+    bool _spilled{false};  //!< are the elements in `_heap`?
+
+    T *_data() { return _spilled ? _heap.data() : _inline.data(); }
+    const T *_data() const { return _spilled ? _heap.data() : _inline.data(); }
+    size_t _capacity() const { return _spilled ? _heap.size() : N; }
+
+    //! Move the elements to the front of the heap vector, which is enlarged to `capacity`
+    void _spill(const size_t capacity) {
+        std::vector<T> heap(capacity);
+        std::move(begin(), end(), heap.begin());
+        _heap = std::move(heap);
+        _end -= _begin;
+        _begin = 0;
+        if (not _spilled) {
+            _inline = {};
+            _spilled = true;
+        }
+    }
+
+  public:
+    SmallVector() = default;
+
+    //! \name Copying and moving
+    //!@{
+    SmallVector(const SmallVector &other) = default;
+    SmallVector &operator=(const SmallVector &other) = default;
+
+    //! \note Leaves `other` empty
+    SmallVector(SmallVector &&other) noexcept
+        : _inline(std::move(other._inline))
+        , _heap(std::move(other._heap))
+        , _begin(other._begin)
+        , _end(other._end)
+        , _spilled(other._spilled) {
+        other._heap.clear();
+        other._begin = other._end = 0;
+        other._spilled = false;
+    }
+
+    //! \note Leaves `other` empty
+    SmallVector &operator=(SmallVector &&other) noexcept {
+        if (this != &other) {
+            _inline = std::move(other._inline);
+            _heap = std::move(other._heap);
+            _begin = other._begin;
+            _end = other._end;
+            _spilled = other._spilled;
+            other._heap.clear();
+            other._begin = other._end = 0;
+            other._spilled = false;
+        }
+        return *this;
+    }
+    //!@}
+
+    //! \brief Add an element at the end
+    void push_back(T value) {
+        if (_end == _capacity()) {
+            if (_begin > 0) {
+                // slide the elements down to make room
+                std::move(begin(), end(), _data());
+                std::fill(_data() + _end - _begin, _data() + _end, T{});
+                _end -= _begin;
+                _begin = 0;
+            } else {
+                _spill(2 * _capacity());
+            }
+        }
+        _data()[_end++] = std::move(value);
+    }
+
+    //! \brief Add an element at the front
+    void push_front(T value) {
+        if (_begin == 0) {
+            if (_end == _capacity()) {
+                _spill(2 * _capacity());
+            }
+            // slide the elements up to make room
+            std::move_backward(begin(), end(), _data() + _end + 1);
+            _begin++;
+            _end++;
+        }
+        _data()[--_begin] = std::move(value);
+    }
+
+    //! \brief Remove the first element
+    void pop_front() {
+        _data()[_begin++] = T{};
+        if (_begin == _end) {
+            _begin = _end = 0;
+        }
+    }
+
+    //! \brief Remove all the elements (but keep any heap storage)
+    void clear() {
+        std::fill(begin(), end(), T{});
+        _begin = _end = 0;
+    }
+
+    //! \name Element access
+    //!@{
+    T &front() { return _data()[_begin]; }
+    const T &front() const { return _data()[_begin]; }
+    T &back() { return _data()[_end - 1]; }
+    const T &back() const { return _data()[_end - 1]; }
+    T &operator[](const size_t n) { return _data()[_begin + n]; }
+    const T &operator[](const size_t n) const { return _data()[_begin + n]; }
+    T *data() { return _data() + _begin; }
+    const T *data() const { return _data() + _begin; }
+    //!@}
+
+    //! \name Iteration
+    //!@{
+    T *begin() { return _data() + _begin; }
+    T *end() { return _data() + _end; }
+    const T *begin() const { return _data() + _begin; }
+    const T *end() const { return _data() + _end; }
+    //!@}
+
+    //! \brief Number of elements
+    size_t size() const { return _end - _begin; }
+
+    //! \brief Are there no elements?
+    bool empty() const { return _begin == _end; }
+
+    //! \brief Have the elements outgrown the inline storage?
+    bool spilled() const { return _spilled; }
+};
+
+#endif  // SPONGE_LIBSPONGE_SMALL_VECTOR_HH
@@ -0,0 +1,83 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_RING_HH
+#define SPONGE_LIBSPONGE_SPSC_RING_HH
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+//! \brief A bounded, lock-free queue from one producer thread to one consumer thread
+
+//! The slots form a ring indexed by two ever-increasing counters: the producer owns `_tail` and
+//! the consumer owns `_head`. Each side publishes its counter with a release store after touching
+//! a slot, and reads the other side's with an acquire load, so a slot is never accessed by both
+//! threads at once. Each side also remembers the last value it saw of the other's counter, and
+//! reloads it only when the ring looks full (or empty), which keeps the two counters' cache lines
+//! from bouncing between the threads on every operation.
+template <typename T>
+class SPSCRing {
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> _slots;
+    size_t _mask;  //!< capacity minus one (the capacity is a power of two)
+
+    alignas(CACHE_LINE) std::atomic<size_t> _head{0};  //!< next slot to pop (written by the consumer)
+    size_t _cached_tail{0};                             //!< the consumer's last view of `_tail`
+
+    alignas(CACHE_LINE) std::atomic<size_t> _tail{0};  //!< next slot to push (written by the producer)
+    size_t _cached_head{0};                             //!< the producer's last view of `_head`
+
+    static size_t _round_up(const size_t capacity) {
+        size_t ret = 1;
+        while (ret < capacity) {
+            ret <<= 1;
+        }
+        return ret;
+    }
+
+  public:
+    //! \param[in] capacity the most elements the ring holds, rounded up to a power of two
+    explicit SPSCRing(const size_t capacity) : _slots(_round_up(capacity)), _mask(_slots.size() - 1) {}
+
+    //! \name Not copyable or movable, since both threads refer to it
+    //!@{
+    SPSCRing(const SPSCRing &other) = delete;
+    SPSCRing &operator=(const SPSCRing &other) = delete;
+    //!@}
+
+    //! \brief Add `value` at the back (producer only)
+    //! \returns `false`, leaving `value` untouched, if the ring is full
+    bool push(T &&value) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cached_head == _slots.size()) {
+            _cached_head = _head.load(std::memory_order_acquire);
+            if (tail - _cached_head == _slots.size()) {
+                return false;
+            }
+        }
+        _slots[tail & _mask] = std::move(value);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Remove the element at the front (consumer only)
+    std::optional<T> pop() {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _cached_tail) {
+            _cached_tail = _tail.load(std::memory_order_acquire);
+            if (head == _cached_tail) {
+                return std::nullopt;
+            }
+        }
+        std::optional<T> ret{std::move(_slots[head & _mask])};
+        _slots[head & _mask] = T{};  // release what the element refers to now, on the consumer's thread
+        _head.store(head + 1, std::memory_order_release);
+        return ret;
+    }
+
+    //! \brief The most elements the ring holds
+    size_t capacity() const { return _slots.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_RING_HH
@@ -0,0 +1,162 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+//! \brief A hierarchical timing wheel with millisecond resolution
+
+//! Components register a deadline (and a payload that identifies what
+//! it is for) with schedule(), and learn which deadlines have passed from
+//! the return value of advance(). The cost of advance() is proportional to
+//! the number of timers that expire (plus a bounded amount of cascading),
+//! not to the number of timers that are pending.
+//!
+//! The wheel has LEVELS levels of SLOTS slots each. Level `k` holds the
+//! timers whose deadline first differs from the current time in base-SLOTS
+//! digit `k`, in the slot given by that digit. Since that digit of the
+//! deadline is always ahead of the current time's, the earliest occupied
+//! slot can be found from a per-level bitmap without scanning. When the
+//! current time reaches a slot on a level above zero, its timers are
+//! redistributed (cascaded) to lower levels.
+template <typename T>
+class TimerWheel {
+  private:
+    static constexpr unsigned BITS = 6;                         //!< log2 of the number of slots per level
+    static constexpr unsigned SLOTS = 1u << BITS;               //!< slots per level
+    static constexpr unsigned LEVELS = (64 + BITS - 1) / BITS;  //!< enough levels to cover any 64-bit deadline
+
+    //! A pending timer
+    struct Timer {
+        uint64_t deadline;  //!< when the timer expires (in milliseconds on the wheel's clock)
+        unsigned level;     //!< level of the slot that holds the timer
+        unsigned slot;      //!< index of the slot within its level
+        T payload;          //!< what the timer is for
+    };
+
+    std::array<std::array<std::list<Timer>, SLOTS>, LEVELS> _slots{};
+    std::array<uint64_t, LEVELS> _occupied{};  //!< bit `i` of `_occupied[k]` is set iff `_slots[k][i]` is non-empty
+    uint64_t _now{0};
+    size_t _size{0};
+
+    static unsigned _highest_bit(const uint64_t x) { return 63 - __builtin_clzll(x); }
+
+    //! Move the timer at `it` (currently in list `from`) into the slot matching its deadline
+    void _place(std::list<Timer> &from, const typename std::list<Timer>::iterator it) {
+        const unsigned level = _highest_bit(it->deadline ^ _now) / BITS;
+        const unsigned slot = (it->deadline >> (level * BITS)) & (SLOTS - 1);
+        it->level = level;
+        it->slot = slot;
+        _slots[level][slot].splice(_slots[level][slot].end(), from, it);
+        _occupied[level] |= uint64_t{1} << slot;
+    }
+
+    void _unlink(const typename std::list<Timer>::iterator it, std::list<Timer> &to) {
+        std::list<Timer> &slot = _slots[it->level][it->slot];
+        to.splice(to.end(), slot, it);
+        if (slot.empty()) {
+            _occupied[it->level] &= ~(uint64_t{1} << it->slot);
+        }
+    }
+
+  public:
+    //! \brief Identifies a pending timer, for cancel() or reschedule()
+    //! \note A handle stays valid until its timer is cancelled or returned by advance().
+    using Handle = typename std::list<Timer>::iterator;
+
+    TimerWheel() = default;
+
+    //! \name Handles refer into the wheel, so it can be moved but not copied
+    //!@{
+    TimerWheel(TimerWheel &&other) = default;
+    TimerWheel &operator=(TimerWheel &&other) = default;
+    TimerWheel(const TimerWheel &other) = delete;
+    TimerWheel &operator=(const TimerWheel &other) = delete;
+    //!@}
+
+    //! \brief Start a timer that expires `delay` milliseconds from now
+    //! \note A delay of zero is treated as one millisecond, so every timer expires in a later advance().
+    Handle schedule(const uint64_t delay, T payload) {
+        std::list<Timer> staging{};
+        staging.push_back({_now + std::max(delay, uint64_t{1}), 0, 0, std::move(payload)});
+        const Handle it = staging.begin();
+        _place(staging, it);
+        _size++;
+        return it;
+    }
+
+    //! \brief Move a pending timer's deadline to `delay` milliseconds from now; the handle stays valid
+    void reschedule(const Handle timer, const uint64_t delay) {
+        std::list<Timer> staging{};
+        _unlink(timer, staging);
+        timer->deadline = _now + std::max(delay, uint64_t{1});
+        _place(staging, timer);
+    }
+
+    //! \brief Stop a pending timer
+    void cancel(const Handle timer) {
+        std::list<Timer> discard{};
+        _unlink(timer, discard);
+        _size--;
+    }
+
+    //! \brief Advance the clock by `ms` milliseconds
+    //! \returns the payloads of the timers that expired, in order of their deadlines
+    std::vector<T> advance(const uint64_t ms) {
+        std::vector<T> expired{};
+        const uint64_t target = _now + ms;
+
+        while (true) {
+            unsigned level = 0;
+            while (level < LEVELS and _occupied[level] == 0) {
+                level++;
+            }
+            if (level == LEVELS) {
+                break;
+            }
+
+            // the earliest occupied slot starts at the current time's prefix above `level`, plus the slot's digit
+            const unsigned shift = level * BITS;
+            const unsigned slot = __builtin_ctzll(_occupied[level]);
+            const uint64_t prefix_mask = shift + BITS >= 64 ? 0 : ~((uint64_t{1} << (shift + BITS)) - 1);
+            const uint64_t slot_start = (_now & prefix_mask) | (uint64_t{slot} << shift);
+            if (slot_start > target) {
+                break;
+            }
+
+            _now = slot_start;
+            std::list<Timer> due{};
+            due.splice(due.end(), _slots[level][slot]);
+            _occupied[level] &= ~(uint64_t{1} << slot);
+
+            while (not due.empty()) {
+                if (due.front().deadline <= _now) {
+                    expired.push_back(std::move(due.front().payload));
+                    due.pop_front();
+                    _size--;
+                } else {
+                    _place(due, due.begin());
+                }
+            }
+        }
+
+        _now = target;
+        return expired;
+    }
+
+    //! \brief Milliseconds elapsed on the wheel's clock
+    uint64_t now() const { return _now; }
+
+    //! \brief Number of pending timers
+    size_t size() const { return _size; }
+
+    //! \brief Are there no pending timers?
+    bool empty() const { return _size == 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
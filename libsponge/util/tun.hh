@@ -7,23 +7,30 @@
 
 //! A FileDescriptor to a [Linux TUN/TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunTapFD : public FileDescriptor {
+  private:
+    bool _vnet_hdr;
+
   public:
     //! Open an existing persistent [TUN or TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunTapFD(const std::string &devname, const bool is_tun);
+    explicit TunTapFD(const std::string &devname, const bool is_tun, const bool vnet_hdr = false);
+
+    //! \brief Does every packet read or written start with a VirtioNetHeader?
+    //! \details If so, the kernel accepts TCP super-packets and partial checksums, and may deliver them.
+    bool vnet_hdr() const { return _vnet_hdr; }
 };
 
 //! A FileDescriptor to a [Linux TUN](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunFD : public TunTapFD {
   public:
     //! Open an existing persistent [TUN device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunFD(const std::string &devname) : TunTapFD(devname, true) {}
+    explicit TunFD(const std::string &devname, const bool vnet_hdr = false) : TunTapFD(devname, true, vnet_hdr) {}
 };
 
 //! A FileDescriptor to a [Linux TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TapFD : public TunTapFD {
   public:
     //! Open an existing persistent [TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TapFD(const std::string &devname) : TunTapFD(devname, false) {}
+    explicit TapFD(const std::string &devname, const bool vnet_hdr = false) : TunTapFD(devname, false, vnet_hdr) {}
 };
 
 #endif  // SPONGE_LIBSPONGE_TUN_HH
@@ -1,13 +1,19 @@
 #include "util.hh"
 
+#include <arpa/inet.h>
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <sys/socket.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -18,6 +24,15 @@ uint64_t timestamp_ms() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(now - program_start).count();
 }
 
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    x ^= x >> 31;
+    return x;
+}
+
 //! \param[in] attempt is the name of the syscall to try (for error reporting)
 //! \param[in] return_value is the return value of the syscall
 //! \param[in] errno_mask is any errno value that is acceptable, e.g., `EAGAIN` when reading a non-blocking fd
@@ -84,27 +99,170 @@ mt19937 get_random_generator() {
 //!
 //! For more information, see the [Wikipedia page](https://en.wikipedia.org/wiki/IPv4_header_checksum)
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
-InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+namespace {
+
+//! \brief Add a 64-bit word to a one's-complement sum, with end-around carry
+//! \note The sum is kept modulo 2^64 - 1, a multiple of 0xffff, so it folds to the same 16-bit sum
+inline uint64_t add_with_carry(const uint64_t sum, const uint64_t word) {
+    const uint64_t ret = sum + word;
+    return ret + (ret < word);
+}
 
-void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+//! \brief Sum `len` bytes of `data` in native-order words, copying them to `dst` if `Copy`
+//! \returns the unfolded one's-complement sum, to be folded and converted to network order by the caller
+template <bool Copy>
+uint64_t checksum_words(char *dst, const char *data, size_t len) {
+    uint64_t sum = 0;
+    while (len >= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        if constexpr (Copy) {
+            memcpy(dst, &word, sizeof(word));
+            dst += sizeof(word);
+        }
+        sum = add_with_carry(sum, word);
+        data += sizeof(word);
+        len -= sizeof(word);
+    }
+    if (len > 0) {
+        uint64_t word = 0;  // the last few bytes, zero-padded in memory order
+        memcpy(&word, data, len);
+        if constexpr (Copy) {
+            memcpy(dst, data, len);
         }
-        _sum += val;
-        _parity = !_parity;
+        sum = add_with_carry(sum, word);
+    }
+    return sum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+//! \brief Sum 16 bytes at a time into four 64-bit lanes, then finish the tail with checksum_words
+template <bool Copy>
+__attribute__((target("sse2"))) uint64_t checksum_words_sse2(char *dst, const char *data, size_t len) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    while (len >= sizeof(__m128i)) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        if constexpr (Copy) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v);
+            dst += sizeof(__m128i);
+        }
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+        data += sizeof(__m128i);
+        len -= sizeof(__m128i);
+    }
+    array<uint64_t, 2> lanes{};
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes.data()), acc);
+    return add_with_carry(add_with_carry(lanes[0], lanes[1]), checksum_words<Copy>(dst, data, len));
+}
+
+//! \brief Sum 32 bytes at a time into eight 64-bit lanes, then finish the tail with checksum_words
+template <bool Copy>
+__attribute__((target("avx2"))) uint64_t checksum_words_avx2(char *dst, const char *data, size_t len) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    while (len >= sizeof(__m256i)) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+        if constexpr (Copy) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+            dst += sizeof(__m256i);
+        }
+        acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(v, zero));
+        acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(v, zero));
+        data += sizeof(__m256i);
+        len -= sizeof(__m256i);
+    }
+    array<uint64_t, 4> lanes{};
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes.data()), acc);
+    uint64_t sum = checksum_words<Copy>(dst, data, len);
+    for (const uint64_t lane : lanes) {
+        sum = add_with_carry(sum, lane);
+    }
+    return sum;
+}
+#endif
+
+//! \brief The fastest implementation of checksum_words that this CPU supports
+template <bool Copy>
+uint64_t (*select_checksum_words())(char *, const char *, size_t) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        return checksum_words_avx2<Copy>;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return checksum_words_sse2<Copy>;
+    }
+#endif
+    return checksum_words<Copy>;
+}
+
+//! Fold a one's-complement sum to 16 bits
+uint16_t fold(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
     }
+    return static_cast<uint16_t>(sum);
 }
 
-uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+}  // namespace
 
-    while (ret > 0xffff) {
-        ret = (ret >> 16) + (ret & 0xffff);
+InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+
+void InternetChecksum::add(std::string_view data) { _add<false>(nullptr, data); }
+
+//! \param[out] dst receives a copy of `data`; must have room for `data.size()` bytes
+//! \param[in] data the bytes to copy and add to the checksum
+void InternetChecksum::add_copy(char *dst, std::string_view data) { _add<true>(dst, data); }
+
+//! \param[in] other the checksum of the data that follows the data summed so far
+void InternetChecksum::add(const InternetChecksum &other) {
+    // data that starts at an odd offset contributes its sum byte-swapped (RFC 1071, section 2(B))
+    const uint16_t other_sum = fold(other._sum);
+    _sum += _parity ? static_cast<uint16_t>((other_sum << 8) | (other_sum >> 8)) : other_sum;
+    _parity = _parity != other._parity;
+}
+
+template <bool Copy>
+void InternetChecksum::_add(char *dst, std::string_view data) {
+    if (data.empty()) {
+        return;
     }
 
-    return ~ret;
+    // an odd number of bytes so far: the next byte is the low half of a 16-bit word
+    if (_parity) {
+        _sum += uint8_t(data.front());
+        if constexpr (Copy) {
+            *dst++ = data.front();
+        }
+        data.remove_prefix(1);
+        _parity = false;
+    }
+
+    // The one's-complement sum of native-order words, folded to 16 bits, is the byte-swap of the
+    // sum of network-order words on a little-endian machine (RFC 1071, section 2(B)).
+    static const auto checksum_words_best = select_checksum_words<Copy>();
+    _sum += ntohs(fold(checksum_words_best(dst, data.data(), data.size())));
+    _parity = data.size() % 2;
+}
+
+uint16_t InternetChecksum::value() const { return ~fold(_sum); }
+
+//! \param[in] checksum the checksum stored with the data
+//! \param[in] old_value the 16-bit word that was summed into `checksum`
+//! \param[in] new_value the word that replaces it
+uint16_t InternetChecksum::adjust(const uint16_t checksum, const uint16_t old_value, const uint16_t new_value) {
+    // HC' = ~(~HC + ~m + m')
+    const uint64_t sum = uint16_t(~checksum) + uint16_t(~old_value) + uint64_t{new_value};
+    return ~fold(sum);
+}
+
+//! \param[in] checksum the checksum stored with the data
+//! \param[in] old_value the 32-bit field (at an even offset) that was summed into `checksum`
+//! \param[in] new_value the field that replaces it
+uint16_t InternetChecksum::adjust(const uint16_t checksum, const uint32_t old_value, const uint32_t new_value) {
+    const uint16_t high = adjust(checksum, uint16_t(old_value >> 16), uint16_t(new_value >> 16));
+    return adjust(high, uint16_t(old_value & 0xffff), uint16_t(new_value & 0xffff));
 }
 
 //! \param[in] data is a pointer to the bytes to show
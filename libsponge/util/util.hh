@@ -51,16 +51,41 @@ std::mt19937 get_random_generator();
 //! Get the time in milliseconds since the program began.
 uint64_t timestamp_ms();
 
-//! The internet checksum algorithm
+//! \brief The SplitMix64 finalizer, which spreads every bit of `x` over the whole result (e.g. for hashing)
+uint64_t mix64(uint64_t x);
+
+//! \brief The internet checksum algorithm
+//! \details Sums the data a machine word (or, where the CPU supports it, an SSE2 or AVX2 vector) at a
+//! time, deferring the folding of carries until value() is called.
 class InternetChecksum {
   private:
-    uint32_t _sum;
-    bool _parity{};
+    uint64_t _sum;
+    bool _parity{};  //!< has an odd number of bytes been added so far?
+
+    //! Add `data`, and if `Copy`, also copy it to `dst`
+    template <bool Copy>
+    void _add(char *dst, std::string_view data);
 
   public:
     InternetChecksum(const uint32_t initial_sum = 0);
     void add(std::string_view data);
     uint16_t value() const;
+
+    //! \brief Add `data` to the checksum while copying it to `dst`, reading it only once
+    void add_copy(char *dst, std::string_view data);
+
+    //! \brief Add the data summed by `other`, as if it had been added here with add()
+    //! \note `other` should not have an initial sum, unless that is meant to be counted twice.
+    void add(const InternetChecksum &other);
+
+    //! \brief Update a stored checksum for a 16-bit field that changed from `old_value` to `new_value`
+    //! \details Uses [RFC 1624](https://tools.ietf.org/html/rfc1624)'s eqn. 3, so the rest of the data
+    //! need not be summed again. Both values are in host byte order, as is the returned checksum.
+    //! \note If the new data is all zeros, the result is 0x0000 rather than 0xffff (RFC 1624, section 3).
+    static uint16_t adjust(const uint16_t checksum, const uint16_t old_value, const uint16_t new_value);
+
+    //! \brief Update a stored checksum for a 32-bit field (e.g. an address or sequence number)
+    static uint16_t adjust(const uint16_t checksum, const uint32_t old_value, const uint32_t new_value);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
@@ -0,0 +1,88 @@
+#include "buffer.hh"
+#include "small_vector.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // a SmallVector behaves like a deque, whether or not it has spilled to the heap
+        for (unsigned int round = 0; round < 100; round++) {
+            SmallVector<string, 4> small;
+            deque<string> reference;
+            for (unsigned int step = 0; step < 200; step++) {
+                const unsigned int action = rd() % 4;
+                const string value = to_string(rd());
+                if (action == 0) {
+                    small.push_back(value);
+                    reference.push_back(value);
+                } else if (action == 1) {
+                    small.push_front(value);
+                    reference.push_front(value);
+                } else if (not reference.empty()) {
+                    small.pop_front();
+                    reference.pop_front();
+                }
+                test_err_if(small.size() != reference.size(), "wrong size");
+                test_err_if(not equal(small.begin(), small.end(), reference.begin(), reference.end()),
+                            "wrong contents");
+            }
+
+            SmallVector<string, 4> copy = small;
+            SmallVector<string, 4> moved = move(small);
+            test_err_if(not equal(moved.begin(), moved.end(), copy.begin(), copy.end()), "move changed contents");
+            test_err_if(not small.empty(), "moved-from SmallVector is not empty");
+        }
+
+        // a header, a few more headers, and a payload stay inline
+        {
+            BufferList list{string("payload")};
+            list.prepend("tcp ");
+            list.prepend("ip ");
+            list.prepend("eth ");
+            test_err_if(list.buffers().spilled(), "a typical packet should not allocate for its pieces");
+            test_err_if(list.concatenate() != "eth ip tcp payload", "wrong contents");
+
+            const auto iovecs = BufferViewList{list}.as_iovecs();
+            test_err_if(iovecs.spilled() or iovecs.size() != 4, "wrong iovecs");
+            string gathered;
+            for (const auto &iov : iovecs) {
+                gathered.append(static_cast<const char *>(iov.iov_base), iov.iov_len);
+            }
+            test_err_if(gathered != list.concatenate(), "iovecs do not cover the list");
+
+            list.remove_prefix(6);
+            test_err_if(list.concatenate() != " tcp payload" or list.buffers().size() != 3, "remove_prefix failed");
+        }
+
+        // many pieces spill to the heap, and still work
+        {
+            BufferList list;
+            string expected;
+            for (unsigned int i = 0; i < 100; i++) {
+                list.append(BufferList{to_string(i)});
+                expected += to_string(i);
+            }
+            test_err_if(not list.buffers().spilled(), "expected to spill");
+            test_err_if(list.concatenate() != expected, "wrong contents after spilling");
+            test_err_if(BufferViewList{list}.as_iovecs().size() != 100, "wrong number of iovecs");
+            list.remove_prefix(50);
+            test_err_if(list.concatenate() != expected.substr(50), "wrong contents after remove_prefix");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include "buffer.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! A TCP segment in an IPv4 datagram in an Ethernet frame, serialized layer by layer
+static BufferList serialize_frame(const Buffer &payload) {
+    TCPSegment seg;
+    seg.header().sport = 1234;
+    seg.header().dport = 80;
+    seg.header().ack = true;
+    seg.payload() = payload;
+
+    InternetDatagram dgram;
+    dgram.header().src = 0x0a000001;
+    dgram.header().dst = 0x0a000002;
+    dgram.header().len = dgram.header().hlen * 4 + seg.header().doff * 4 + payload.size();
+    dgram.payload() = seg.serialize(dgram.header().pseudo_cksum());
+
+    EthernetFrame frame;
+    frame.header().type = EthernetHeader::TYPE_IPv4;
+    frame.payload() = dgram.serialize();
+    return frame.serialize();
+}
+
+int main() {
+    try {
+        // headers are written into the headroom, once
+        {
+            Buffer buf{4, "payload"};
+            Buffer copy = buf;
+            test_err_if(not buf.prepend("ab"), "prepend into headroom failed");
+            test_err_if(buf.str() != "abpayload" or copy.str() != "payload", "wrong contents after prepend");
+            test_err_if(copy.prepend("xy"), "a copy claimed headroom that was already claimed");
+            test_err_if(not buf.prepend("cd") or buf.str() != "cdabpayload", "second prepend failed");
+            test_err_if(buf.prepend("e"), "prepend beyond the headroom succeeded");
+            test_err_if(Buffer{string("no headroom")}.prepend("x"), "prepend without headroom succeeded");
+        }
+
+        // a pooled payload becomes a single contiguous frame, identical to the unpooled one
+        {
+            BufferPool pool;
+            const string data(1000, 'x');
+            const BufferList pooled = serialize_frame(pool.take(data));
+            const BufferList unpooled = serialize_frame(Buffer{string(data)});
+            test_err_if(pooled.buffers().size() != 1, "pooled frame is not contiguous");
+            test_err_if(unpooled.buffers().size() != 4, "unpooled frame should have one piece per layer");
+            test_err_if(pooled.concatenate() != unpooled.concatenate(), "pooled frame differs");
+
+            // serializing the same payload again cannot reuse the claimed headroom, but is still correct
+            const Buffer payload = pool.take(data);
+            const BufferList first = serialize_frame(payload);
+            const BufferList second = serialize_frame(payload);
+            test_err_if(first.buffers().size() != 1 or second.buffers().size() != 4, "headroom claimed twice");
+            test_err_if(first.concatenate() != unpooled.concatenate() or second.concatenate() != first.concatenate(),
+                        "reserialized frame differs");
+        }
+
+        // the pool checksums the data it copies in, for the whole payload only
+        {
+            BufferPool pool;
+            for (const size_t size : {size_t{1}, size_t{7}, size_t{1000}, BufferPool::SLAB_SIZE}) {
+                string data(size, 0);
+                for (size_t i = 0; i < size; i++) {
+                    data[i] = static_cast<char>(i * 7 + size);
+                }
+                Buffer buf = pool.take(data);
+                InternetChecksum expected;
+                expected.add(data);
+                test_err_if(not buf.checksum().has_value() or buf.checksum()->value() != expected.value(),
+                            "wrong checksum for pooled buffer");
+
+                Buffer with_header = buf;
+                test_err_if(not with_header.prepend("hdr") or with_header.checksum().has_value(),
+                            "checksum should not cover a prepended header");
+                test_err_if(buf.checksum()->value() != expected.value(), "prepend changed the checksum");
+                buf.remove_prefix(1);
+                test_err_if(buf.checksum().has_value(), "checksum should not cover a shortened buffer");
+            }
+            test_err_if(Buffer{string("unpooled")}.checksum().has_value(), "unpooled buffer has a checksum");
+        }
+
+        // slabs are reused once released
+        {
+            BufferPool pool;
+            for (unsigned int i = 0; i < 1000; i++) {
+                const Buffer buf = pool.take(to_string(i));
+                test_err_if(buf.str() != to_string(i), "wrong contents");
+            }
+            test_err_if(pool.slabs() != 1, "released slab was not reused");
+
+            vector<Buffer> held;
+            for (unsigned int i = 0; i < 10; i++) {
+                held.push_back(pool.take(to_string(i)));
+            }
+            test_err_if(pool.slabs() != 10, "expected one slab per held buffer");
+            for (unsigned int i = 0; i < 10; i++) {
+                test_err_if(held[i].str() != to_string(i), "held buffer was overwritten");
+            }
+
+            test_err_if(pool.take(string(BufferPool::SLAB_SIZE, 'x')).size() != BufferPool::SLAB_SIZE,
+                        "oversized buffer truncated");
+            test_err_if(pool.slabs() != 10, "oversized buffer took a slab");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
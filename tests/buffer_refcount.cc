@@ -0,0 +1,79 @@
+#include "buffer.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // copies share the storage and outlive the original
+        {
+            Buffer copy;
+            {
+                Buffer original{string("hello, world")};
+                copy = original;
+                Buffer moved = move(original);
+                test_err_if(moved.str().data() != copy.str().data(), "copies do not share storage");
+                test_err_if(original.size() != 0, "moved-from Buffer is not empty");
+            }
+            test_err_if(copy.str() != "hello, world", "copy did not keep the storage alive");
+            copy.remove_prefix(copy.size());
+            test_err_if(copy.size() != 0, "remove_prefix failed");
+        }
+
+        // a Buffer with no other copies becomes thread-safe in place; otherwise it is copied
+        if (not Buffer::THREAD_SAFE_BY_DEFAULT) {
+            Buffer unique{string("unique")};
+            const char *const data = unique.str().data();
+            test_err_if(unique.thread_safe().str().data() != data, "unique Buffer was copied");
+
+            const Buffer shared{string("shared")};
+            const Buffer other_copy = shared;
+            const Buffer converted = shared.thread_safe();
+            test_err_if(converted.str().data() == shared.str().data(), "shared Buffer was not copied");
+            test_err_if(converted.str() != "shared", "wrong contents");
+        }
+
+        // thread-safe Buffers can be copied and destroyed on several threads at once
+        {
+            const Buffer buf = Buffer{string(1000, 'x')}.thread_safe();
+            const BufferList list = BufferList{buf}.thread_safe();
+            vector<thread> threads;
+            for (unsigned int i = 0; i < 4; i++) {
+                threads.emplace_back([&] {
+                    for (unsigned int j = 0; j < 100000; j++) {
+                        const Buffer copy = buf;
+                        const BufferList list_copy = list;
+                        if (copy.size() != 1000 or list_copy.size() != 1000) {
+                            abort();
+                        }
+                    }
+                });
+            }
+            for (auto &t : threads) {
+                t.join();
+            }
+            test_err_if(buf.str() != string(1000, 'x'), "contents changed");
+        }
+
+        // so can the Buffers of a thread-safe pool
+        {
+            BufferPool pool{true};
+            const Buffer buf = pool.take("pooled");
+            thread t([copy = buf]() mutable { copy = Buffer{}; });
+            t.join();
+            test_err_if(buf.str() != "pooled", "pooled Buffer changed");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
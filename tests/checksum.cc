@@ -0,0 +1,189 @@
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! The original byte-at-a-time checksum, as a reference
+static uint16_t reference_checksum(const uint32_t initial_sum, const vector<string> &pieces) {
+    uint32_t sum = initial_sum;
+    bool parity = false;
+    for (const auto &piece : pieces) {
+        for (const char c : piece) {
+            uint16_t val = uint8_t(c);
+            if (not parity) {
+                val <<= 8;
+            }
+            sum += val;
+            parity = not parity;
+        }
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+static uint16_t checksum(const uint32_t initial_sum, const vector<string> &pieces) {
+    InternetChecksum check{initial_sum};
+    for (const auto &piece : pieces) {
+        check.add(piece);
+    }
+    return check.value();
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // random data, split at random (odd and even) offsets and misaligned in memory
+        for (unsigned int i = 0; i < 10000; i++) {
+            const uint32_t initial_sum = rd() % 2 ? 0 : static_cast<uint32_t>(rd()) >> 1;
+            const size_t alphabet = rd() % 3;  // all zeros, all 0xff, or random bytes
+            vector<string> pieces(rd() % 5);
+            for (auto &piece : pieces) {
+                piece.resize(rd() % 2 ? rd() % 40 : rd() % 3000);
+                for (auto &c : piece) {
+                    c = alphabet == 0 ? 0 : alphabet == 1 ? '\xff' : static_cast<char>(rd());
+                }
+            }
+            const uint16_t expected = reference_checksum(initial_sum, pieces);
+            test_err_if(checksum(initial_sum, pieces) != expected, "checksum differs from reference");
+
+            string joined;
+            for (const auto &piece : pieces) {
+                joined += piece;
+            }
+            const size_t misalignment = rd() % 32;
+            const string padded = string(misalignment, 'x') + joined;
+            InternetChecksum check{initial_sum};
+            check.add(string_view{padded}.substr(misalignment));
+            test_err_if(check.value() != expected, "checksum depends on alignment or split");
+        }
+
+        // copying while checksumming, and combining checksums of consecutive pieces, give the same sums
+        for (unsigned int i = 0; i < 1000; i++) {
+            vector<string> pieces(1 + rd() % 4);
+            string joined;
+            for (auto &piece : pieces) {
+                piece.resize(rd() % 2000);
+                for (auto &c : piece) {
+                    c = static_cast<char>(rd());
+                }
+                joined += piece;
+            }
+
+            InternetChecksum copied;
+            InternetChecksum combined;
+            string copy(joined.size(), 0);
+            size_t offset = 0;
+            for (const auto &piece : pieces) {
+                copied.add_copy(copy.data() + offset, piece);
+                offset += piece.size();
+                InternetChecksum piece_checksum;
+                piece_checksum.add(piece);
+                combined.add(piece_checksum);
+            }
+            test_err_if(copy != joined, "add_copy() did not copy");
+            test_err_if(copied.value() != reference_checksum(0, pieces), "add_copy() checksum differs");
+            test_err_if(combined.value() != reference_checksum(0, pieces), "combined checksum differs");
+        }
+
+        // adjusting a checksum for a changed field agrees with recomputing it
+        for (unsigned int i = 0; i < 10000; i++) {
+            string data(2 * (3 + rd() % 30), 0);
+            for (auto &c : data) {
+                c = rd() % 4 ? static_cast<char>(rd()) : 0;
+            }
+            data[0] = 0x45;  // data that sums to zero is the one case where the results may differ
+            InternetChecksum before;
+            before.add(data);
+
+            const size_t offset = 2 * (1 + rd() % (data.size() / 2 - 2));  // room for a 32-bit field
+            if (rd() % 2) {
+                const uint16_t old_value = load_big_endian<uint16_t>(data.data() + offset);
+                const uint16_t new_value = rd() % 4 ? static_cast<uint16_t>(rd()) : 0;
+                store_big_endian(data.data() + offset, new_value);
+                InternetChecksum after;
+                after.add(data);
+                test_err_if(InternetChecksum::adjust(before.value(), old_value, new_value) != after.value(),
+                            "16-bit adjustment differs from recomputation");
+            } else {
+                const uint32_t old_value = load_big_endian<uint32_t>(data.data() + offset);
+                const uint32_t new_value = static_cast<uint32_t>(rd());
+                store_big_endian(data.data() + offset, new_value);
+                InternetChecksum after;
+                after.add(data);
+                test_err_if(InternetChecksum::adjust(before.value(), old_value, new_value) != after.value(),
+                            "32-bit adjustment differs from recomputation");
+            }
+        }
+
+        // a forwarded datagram keeps a valid checksum without recomputing it
+        for (unsigned int i = 0; i < 1000; i++) {
+            IPv4Datagram dgram;
+            dgram.header().ttl = 1 + rd() % 255;
+            dgram.header().proto = static_cast<uint8_t>(rd());
+            dgram.header().id = static_cast<uint16_t>(rd());
+            dgram.header().src = static_cast<uint32_t>(rd());
+            dgram.header().dst = static_cast<uint32_t>(rd());
+            dgram.header().len = IPv4Header::LENGTH + 5;
+            dgram.payload() = string("hello");
+
+            IPv4Datagram forwarded;
+            test_err_if(forwarded.parse(Buffer{dgram.serialize().concatenate()}) != ParseResult::NoError,
+                        "datagram did not parse");
+            const uint8_t ttl = dgram.header().ttl;
+            if (not forwarded.decrement_ttl()) {
+                test_err_if(ttl != 1, "decrement_ttl() refused a datagram with TTL remaining");
+                continue;
+            }
+
+            IPv4Datagram received;
+            test_err_if(received.parse(Buffer{forwarded.serialize().concatenate()}) != ParseResult::NoError,
+                        "forwarded datagram has a bad checksum");
+            test_err_if(received.header().ttl != ttl - 1, "wrong TTL");
+            dgram.header().ttl--;
+            test_err_if(received.serialize().concatenate() != dgram.serialize().concatenate(),
+                        "forwarded datagram differs from a freshly built one");
+        }
+
+        // a forwarded datagram with options (which are not kept) gets a checksum over the header it is sent with
+        {
+            string header("\x46\x00\x00\x1d\x00\x01\x00\x00\x40\x11\x00\x00\x0a\x00\x00\x01\x0a\x00\x00\x02"
+                          "\x94\x04\x00\x00",
+                          24);
+            InternetChecksum check;
+            check.add(header);
+            store_big_endian(header.data() + 10, check.value());
+
+            IPv4Datagram forwarded;
+            test_err_if(forwarded.parse(Buffer{header + "hello"}) != ParseResult::NoError, "datagram did not parse");
+            test_err_if(not forwarded.decrement_ttl(), "decrement_ttl() refused a datagram with TTL remaining");
+            const string sent = forwarded.serialize().concatenate();
+            InternetChecksum sent_check;
+            sent_check.add(string_view{sent}.substr(0, 4 * forwarded.header().hlen));
+            test_err_if(sent_check.value() != 0, "forwarded header with options has a bad checksum");
+        }
+
+        // a valid header checksums to zero
+        {
+            const string header("\x45\x00\x00\x73\x00\x00\x40\x00\x40\x11\xb8\x61\xc0\xa8\x00\x01\xc0\xa8\x00\xc7", 20);
+            InternetChecksum check;
+            check.add(header);
+            test_err_if(check.value() != 0, "valid header did not checksum to zero");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+#include "flow_cache.hh"
+#include "forwarding_table.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <unordered_map>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // capacity is rounded up to whole sets
+        test_err_if(FlowCache{1}.capacity() != FlowCache::WAYS, "wrong capacity");
+        test_err_if(FlowCache{1000}.capacity() != 1024, "wrong capacity");
+
+        // entries are found until replaced, and the least recently used entry of a set is replaced first
+        {
+            FlowCache cache{FlowCache::WAYS};  // a single set
+            test_err_if(cache.find(1).has_value(), "empty cache has an entry");
+            for (uint32_t address = 1; address <= FlowCache::WAYS; address++) {
+                cache.insert(address, address + 100);
+            }
+            test_err_if(cache.find(1) != 101u, "lost an entry");  // 1 is now the most recently used
+            cache.insert(1000, ForwardingTable::NO_ROUTE);
+            test_err_if(cache.find(2).has_value(), "least recently used entry was kept");
+            test_err_if(cache.find(1) != 101u or cache.find(3) != 103u or cache.find(4) != 104u,
+                        "replaced the wrong entry");
+            test_err_if(cache.find(1000) != ForwardingTable::NO_ROUTE, "lost a cached miss");
+            test_err_if(cache.hits() != 5 or cache.misses() != 2, "wrong counters");
+
+            cache.clear();
+            test_err_if(cache.find(1).has_value(), "entry survived clear()");
+        }
+
+        // the cache never returns a stale route, whatever the access pattern
+        {
+            FlowCache cache{64};
+            unordered_map<uint32_t, uint32_t> routes;
+            for (unsigned int i = 0; i < 100000; i++) {
+                const uint32_t address = rd() % 256;
+                if (routes.count(address) == 0) {
+                    routes[address] = static_cast<uint32_t>(rd());
+                }
+                const auto cached = cache.find(address);
+                if (cached.has_value()) {
+                    test_err_if(cached.value() != routes[address], "cached route is wrong");
+                } else {
+                    cache.insert(address, routes[address]);
+                }
+            }
+            test_err_if(cache.hits() + cache.misses() != 100000, "wrong counters");
+            test_err_if(cache.hits() < 10000, "cache hardly ever hits");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+#include "forwarding_table.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! A random prefix, often nested in (or next to) one of `prefixes`, so that routes overlap
+static pair<uint32_t, uint8_t> random_prefix(mt19937 &rd, const vector<pair<uint32_t, uint8_t>> &prefixes) {
+    // mostly /8 and longer; shorter prefixes are rare, and expensive for a DIR-24-8 table to insert
+    const auto prefix_length = static_cast<uint8_t>(rd() % 16 == 0 ? rd() % 8 : 8 + rd() % 25);
+    uint32_t prefix = static_cast<uint32_t>(rd());
+    if (not prefixes.empty() and rd() % 4 != 0) {
+        const auto &base = prefixes[rd() % prefixes.size()];
+        const uint32_t flip = base.second == 0 ? 0 : uint32_t{1} << (32 - base.second);
+        prefix = (base.first & ForwardingTable::mask(base.second)) | (prefix & ~ForwardingTable::mask(base.second));
+        if (rd() % 4 == 0) {
+            prefix ^= flip;
+        }
+    }
+    return {prefix, prefix_length};
+}
+
+//! An address likely to fall into (or just outside) one of `prefixes`
+static uint32_t random_address(mt19937 &rd, const vector<pair<uint32_t, uint8_t>> &prefixes) {
+    uint32_t address = static_cast<uint32_t>(rd());
+    if (not prefixes.empty() and rd() % 8 != 0) {
+        const auto &base = prefixes[rd() % prefixes.size()];
+        const uint32_t mask = ForwardingTable::mask(base.second);
+        address = (base.first & mask) | (address & ~mask);
+        if (rd() % 8 == 0) {
+            address ^= uint32_t{1} << (rd() % 32);
+        }
+    }
+    return address;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // a few routes, by hand
+        {
+            TrieForwardingTable trie;
+            test_err_if(trie.lookup(0x0a000001) != ForwardingTable::NO_ROUTE, "empty table has a route");
+            trie.insert(0x0a000000, 8, 1);
+            trie.insert(0x0a010000, 16, 2);
+            trie.insert(0x0a010203, 32, 3);
+            trie.insert(0x0a0100ff, 16, 4);  // same prefix as route 2; the first one wins
+            test_err_if(trie.lookup(0x0b000000) != ForwardingTable::NO_ROUTE, "unmatched address has a route");
+            test_err_if(trie.lookup(0x0a020304) != 1, "wrong /8 match");
+            test_err_if(trie.lookup(0x0a01ffff) != 2, "wrong /16 match");
+            test_err_if(trie.lookup(0x0a010203) != 3, "wrong /32 match");
+            test_err_if(trie.lookup(0x0a010202) != 2, "wrong match next to a /32");
+            trie.insert(0, 0, 5);
+            test_err_if(trie.lookup(0x0b000000) != 5, "default route not used");
+            test_err_if(trie.lookup(0x0a010203) != 3, "default route preferred to a longer prefix");
+        }
+
+        // the trie and the DIR-24-8 table agree with a linear scan, and the trie stays small
+        for (unsigned int round = 0; round < 20; round++) {
+            LinearForwardingTable linear;
+            TrieForwardingTable trie;
+            Dir24_8ForwardingTable dir24_8;
+            vector<pair<uint32_t, uint8_t>> prefixes;
+            const unsigned int routes = rd() % 500;
+            for (unsigned int route = 0; route < routes; route++) {
+                const auto prefix = random_prefix(rd, prefixes);
+                prefixes.push_back(prefix);
+                linear.insert(prefix.first, prefix.second, route);
+                trie.insert(prefix.first, prefix.second, route);
+                dir24_8.insert(prefix.first, prefix.second, route);
+
+                if (route % 50 == 0) {
+                    for (unsigned int i = 0; i < 100; i++) {
+                        const uint32_t address = random_address(rd, prefixes);
+                        test_err_if(trie.lookup(address) != linear.lookup(address),
+                                    "trie disagrees with linear scan while growing");
+                        test_err_if(dir24_8.lookup(address) != linear.lookup(address),
+                                    "DIR-24-8 table disagrees with linear scan while growing");
+                    }
+                }
+            }
+            for (unsigned int i = 0; i < 10000; i++) {
+                const uint32_t address = random_address(rd, prefixes);
+                test_err_if(trie.lookup(address) != linear.lookup(address), "trie disagrees with linear scan");
+                test_err_if(dir24_8.lookup(address) != linear.lookup(address),
+                            "DIR-24-8 table disagrees with linear scan");
+            }
+            test_err_if(trie.size() > 2 * routes + 1, "trie has too many nodes");
+        }
+
+        // the DIR-24-8 table holds more routes than fit in 16 bits, in both levels
+        {
+            Dir24_8ForwardingTable dir24_8;
+            const uint32_t routes = 70000;
+            for (uint32_t route = 0; route < routes; route++) {
+                dir24_8.insert(route << 8 | (route % 2 ? 0x80 : 0), route % 2 ? 25 : 24, route);
+            }
+            for (uint32_t route = 0; route < routes; route++) {
+                test_err_if(dir24_8.lookup(route << 8 | 0xff) != route, "wrong route " + to_string(route));
+                test_err_if(route % 2 and dir24_8.lookup(route << 8) != ForwardingTable::NO_ROUTE,
+                            "route " + to_string(route) + " covers too much");
+            }
+        }
+
+        // every kind of table can be made
+        for (const auto kind :
+             {ForwardingTable::Kind::Linear, ForwardingTable::Kind::Trie, ForwardingTable::Kind::Dir24_8}) {
+            const auto table = ForwardingTable::make(kind);
+            table->insert(0x0a000000, 8, 0);
+            table->insert(0x0a010280, 25, 1);
+            test_err_if(table->lookup(0x0a010281) != 1 or table->lookup(0x0a010201) != 0 or
+                            table->lookup(0x0b000000) != ForwardingTable::NO_ROUTE,
+                        "wrong lookups");
+            test_err_if(table->prefetches() != (kind == ForwardingTable::Kind::Dir24_8), "wrong prefetches()");
+        }
+
+        // prefixes longer than an address are rejected
+        {
+            TrieForwardingTable trie;
+            bool threw = false;
+            try {
+                trie.insert(0, 33, 0);
+            } catch (const exception &) {
+                threw = true;
+            }
+            test_err_if(not threw, "accepted a 33-bit prefix");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! Serialize `header` into caller memory, checking that exactly `length` bytes are written
+template <typename Header>
+static string serialize_exactly(const Header &header, const size_t length) {
+    array<char, 128> out;
+    out.fill('\xa5');
+    header.serialize(out.data());
+    for (size_t i = length; i < out.size(); i++) {
+        test_err_if(out[i] != '\xa5', "serialize() wrote past the end of the header");
+    }
+    return string(out.data(), length);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (unsigned int i = 0; i < 1000; i++) {
+            TCPHeader tcp;
+            tcp.sport = static_cast<uint16_t>(rd());
+            tcp.dport = static_cast<uint16_t>(rd());
+            tcp.seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            tcp.ackno = WrappingInt32{static_cast<uint32_t>(rd())};
+            tcp.doff = TCPHeader::LENGTH / 4 + rd() % 3;
+            tcp.ack = rd() % 2;
+            tcp.syn = rd() % 2;
+            tcp.win = static_cast<uint16_t>(rd());
+            tcp.cksum = static_cast<uint16_t>(rd());
+            if (rd() % 2) {
+                tcp.fast_open_cookie = string(4 + rd() % 13, static_cast<char>(rd()));
+            }
+            const string tcp_raw = serialize_exactly(tcp, 4 * tcp.serialized_doff());
+            test_err_if(tcp_raw != tcp.serialize(), "TCP serializations disagree");
+            TCPHeader tcp_parsed;
+            NetParser tcp_parser{Buffer{string(tcp_raw)}};
+            test_err_if(tcp_parsed.parse(tcp_parser) != ParseResult::NoError, "TCP header did not parse");
+            test_err_if(tcp_parsed.fast_open_cookie != tcp.fast_open_cookie or tcp_parsed.win != tcp.win or
+                            tcp_parsed.seqno != tcp.seqno or tcp_parsed.cksum != tcp.cksum,
+                        "TCP header did not survive serialization");
+
+            IPv4Header ip;
+            ip.hlen = IPv4Header::LENGTH / 4 + rd() % 3;
+            ip.len = static_cast<uint16_t>(rd());
+            ip.id = static_cast<uint16_t>(rd());
+            ip.df = rd() % 2;
+            ip.ttl = static_cast<uint8_t>(rd());
+            ip.cksum = static_cast<uint16_t>(rd());
+            ip.src = static_cast<uint32_t>(rd());
+            ip.dst = static_cast<uint32_t>(rd());
+            const string ip_raw = serialize_exactly(ip, 4 * ip.hlen);
+            test_err_if(ip_raw != ip.serialize(), "IPv4 serializations disagree");
+            test_err_if(load_big_endian<uint32_t>(ip_raw.data() + 12) != ip.src or
+                            load_big_endian<uint16_t>(ip_raw.data() + 10) != ip.cksum,
+                        "wrong IPv4 fields");
+
+            EthernetHeader eth;
+            eth.dst = {1, 2, 3, 4, 5, static_cast<uint8_t>(rd())};
+            eth.src = {6, 7, 8, 9, 10, static_cast<uint8_t>(rd())};
+            eth.type = static_cast<uint16_t>(rd());
+            test_err_if(serialize_exactly(eth, EthernetHeader::LENGTH) != eth.serialize(),
+                        "Ethernet serializations disagree");
+
+            ARPMessage arp;
+            arp.opcode = rd() % 2 ? ARPMessage::OPCODE_REQUEST : ARPMessage::OPCODE_REPLY;
+            arp.sender_ethernet_address = eth.src;
+            arp.sender_ip_address = static_cast<uint32_t>(rd());
+            arp.target_ethernet_address = eth.dst;
+            arp.target_ip_address = static_cast<uint32_t>(rd());
+            const string arp_raw = serialize_exactly(arp, ARPMessage::LENGTH);
+            test_err_if(arp_raw != arp.serialize(), "ARP serializations disagree");
+            ARPMessage arp_parsed;
+            test_err_if(arp_parsed.parse(Buffer{string(arp_raw)}) != ParseResult::NoError or
+                            arp_parsed.to_string() != arp.to_string(),
+                        "ARP message did not survive serialization");
+        }
+
+        // the checksums patched into the stack-serialized headers verify
+        for (unsigned int i = 0; i < 100; i++) {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            seg.header().cksum = static_cast<uint16_t>(rd());  // stale; must be recomputed
+            if (rd() % 2) {
+                seg.header().fast_open_cookie = string("cookie");
+            }
+            seg.payload() = string(rd() % 100, 'x');
+
+            InternetDatagram dgram;
+            dgram.header().src = static_cast<uint32_t>(rd());
+            dgram.header().dst = static_cast<uint32_t>(rd());
+            dgram.header().cksum = static_cast<uint16_t>(rd());  // stale; must be recomputed
+            dgram.header().len = 4 * dgram.header().hlen + 4 * seg.header().serialized_doff() + seg.payload().size();
+            dgram.payload() = seg.serialize(dgram.header().pseudo_cksum());
+
+            InternetDatagram dgram_parsed;
+            test_err_if(dgram_parsed.parse(Buffer{dgram.serialize().concatenate()}) != ParseResult::NoError,
+                        "IPv4 datagram did not parse");
+            TCPSegment seg_parsed;
+            test_err_if(seg_parsed.parse(dgram_parsed.payload().concatenate(), dgram_parsed.header().pseudo_cksum()) !=
+                            ParseResult::NoError,
+                        "TCP segment did not parse");
+            test_err_if(seg_parsed.header().seqno != seg.header().seqno or
+                            seg_parsed.payload().str() != seg.payload().str(),
+                        "TCP segment did not survive serialization");
+        }
+
+        // a retransmission patched into the cached header matches a freshly serialized segment
+        for (unsigned int i = 0; i < 1000; i++) {
+            BufferPool pool;
+            TCPSegment original;
+            original.header().seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            original.header().fin = rd() % 2;
+            original.payload() = rd() % 2 ? pool.take(string(rd() % 1000, 'x')) : Buffer{string(rd() % 100, 'y')};
+            original.cache_serialization();
+            const uint32_t pseudo_cksum = static_cast<uint32_t>(rd()) >> 1;
+
+            TCPSegment first = original;
+            first.header().ack = rd() % 2;
+            first.header().ackno = WrappingInt32{static_cast<uint32_t>(rd())};
+            first.header().win = static_cast<uint16_t>(rd());
+            const string first_raw = first.serialize(pseudo_cksum).concatenate();
+
+            for (unsigned int retx = 0; retx < 3; retx++) {
+                TCPSegment again = original;
+                again.header().ack = rd() % 2;
+                again.header().ackno = WrappingInt32{static_cast<uint32_t>(rd())};
+                again.header().win = static_cast<uint16_t>(rd());
+                if (rd() % 4 == 0) {
+                    again.header().seqno = again.header().seqno + 1;  // not patchable
+                }
+
+                TCPSegment fresh;
+                fresh.header() = again.header();
+                fresh.payload() = Buffer{again.payload().copy()};
+                const string expected = fresh.serialize(pseudo_cksum).concatenate();
+                test_err_if(again.serialize(pseudo_cksum).concatenate() != expected,
+                            "retransmission differs from a freshly serialized segment");
+                test_err_if(again.serialize(pseudo_cksum + 1).concatenate() !=
+                                fresh.serialize(pseudo_cksum + 1).concatenate(),
+                            "retransmission with another pseudo-header differs");
+            }
+            test_err_if(first.serialize(pseudo_cksum).concatenate() != first_raw, "reserialization differs");
+        }
+
+        // a frame sent with a pre-serialized header, and a datagram moved into it, serialize as usual
+        {
+            InternetDatagram dgram;
+            dgram.header().src = static_cast<uint32_t>(rd());
+            dgram.header().dst = static_cast<uint32_t>(rd());
+            dgram.payload() = string("payload");
+            dgram.header().len = 4 * dgram.header().hlen + dgram.payload().size();
+            const string dgram_raw = dgram.serialize().concatenate();
+            test_err_if(move(dgram).serialize().concatenate() != dgram_raw, "moved datagram serializes differently");
+
+            EthernetFrame frame;
+            frame.header() = {{1, 2, 3, 4, 5, 6}, {7, 8, 9, 10, 11, 12}, EthernetHeader::TYPE_IPv4};
+            frame.payload() = string(dgram_raw);
+            const string frame_raw = frame.serialize().concatenate();
+
+            array<char, EthernetHeader::LENGTH> serialized{};
+            frame.header().serialize(serialized.data());
+            EthernetFrame prepared;
+            prepared.set_header(frame.header(), serialized);
+            prepared.payload() = string(dgram_raw);
+            test_err_if(prepared.serialize().concatenate() != frame_raw, "pre-serialized header differs");
+            prepared.header().type = EthernetHeader::TYPE_ARP;
+            test_err_if(prepared.serialize().concatenate().substr(12, 2) != "\x08\x06",
+                        "modified header not reserialized");
+            test_err_if(move(frame).serialize().concatenate() != frame_raw, "moved frame serializes differently");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "arp_message.hh"
+#include "ethernet_header.hh"
+#include "ipv4_header.hh"
+#include "network_interface.hh"
+#include "tcp_header.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static EthernetAddress random_ethernet_address(mt19937 &rd) {
+    EthernetAddress ret;
+    for (auto &byte : ret) {
+        byte = static_cast<uint8_t>(rd());
+    }
+    return ret;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        test_err_if(load_big_endian<uint32_t>("\x01\x02\x03\x04") != 0x01020304, "wrong byte order");
+        test_err_if(load_big_endian<uint16_t>("\xff\xfe") != 0xfffe, "wrong byte order");
+
+        for (unsigned int i = 0; i < 1000; i++) {
+            IPv4Header ip;
+            ip.len = static_cast<uint16_t>(rd());
+            ip.ttl = static_cast<uint8_t>(rd());
+            ip.proto = static_cast<uint8_t>(rd());
+            ip.src = static_cast<uint32_t>(rd());
+            ip.dst = static_cast<uint32_t>(rd());
+            const string ip_raw = ip.serialize() + "payload";
+            const IPv4HeaderView ip_view{ip_raw};
+            test_err_if(not ip_view.valid(), "IPv4 header not valid");
+            test_err_if(ip_view.ver() != ip.ver or ip_view.hlen() != ip.hlen or ip_view.len() != ip.len or
+                            ip_view.ttl() != ip.ttl or ip_view.proto() != ip.proto or ip_view.src() != ip.src or
+                            ip_view.dst() != ip.dst,
+                        "IPv4 view disagrees with header");
+            test_err_if(ip_view.payload() != "payload", "wrong IPv4 payload");
+            test_err_if(IPv4HeaderView{string_view{ip_raw}.substr(0, 19)}.valid(), "truncated IPv4 header valid");
+
+            TCPHeader tcp;
+            tcp.sport = static_cast<uint16_t>(rd());
+            tcp.dport = static_cast<uint16_t>(rd());
+            tcp.seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            tcp.ackno = WrappingInt32{static_cast<uint32_t>(rd())};
+            tcp.urg = rd() % 2;
+            tcp.ack = rd() % 2;
+            tcp.psh = rd() % 2;
+            tcp.rst = rd() % 2;
+            tcp.syn = rd() % 2;
+            tcp.fin = rd() % 2;
+            tcp.win = static_cast<uint16_t>(rd());
+            if (rd() % 2) {
+                tcp.fast_open_cookie = string("cookie");
+            }
+            const string tcp_raw = tcp.serialize() + "data";
+            const TCPHeaderView tcp_view{tcp_raw};
+            test_err_if(not tcp_view.valid(), "TCP header not valid");
+            test_err_if(tcp_view.sport() != tcp.sport or tcp_view.dport() != tcp.dport or
+                            tcp_view.seqno() != tcp.seqno or tcp_view.ackno() != tcp.ackno or
+                            tcp_view.win() != tcp.win,
+                        "TCP view disagrees with header");
+            test_err_if(tcp_view.urg() != tcp.urg or tcp_view.ack() != tcp.ack or tcp_view.psh() != tcp.psh or
+                            tcp_view.rst() != tcp.rst or tcp_view.syn() != tcp.syn or tcp_view.fin() != tcp.fin,
+                        "TCP view flags disagree with header");
+            test_err_if(tcp_view.payload() != "data", "wrong TCP payload (options not skipped?)");
+
+            EthernetHeader eth{random_ethernet_address(rd), random_ethernet_address(rd), EthernetHeader::TYPE_ARP};
+            ARPMessage arp;
+            arp.opcode = rd() % 2 ? ARPMessage::OPCODE_REQUEST : ARPMessage::OPCODE_REPLY;
+            arp.sender_ethernet_address = random_ethernet_address(rd);
+            arp.sender_ip_address = static_cast<uint32_t>(rd());
+            arp.target_ethernet_address = random_ethernet_address(rd);
+            arp.target_ip_address = static_cast<uint32_t>(rd());
+            const string frame_raw = eth.serialize() + arp.serialize();
+            const EthernetHeaderView eth_view{frame_raw};
+            test_err_if(not eth_view.valid() or eth_view.dst() != eth.dst or eth_view.src() != eth.src or
+                            eth_view.type() != eth.type,
+                        "Ethernet view disagrees with header");
+            const ARPMessageView arp_view{eth_view.payload()};
+            test_err_if(not arp_view.valid() or arp_view.opcode() != arp.opcode or
+                            arp_view.sender_ethernet_address() != arp.sender_ethernet_address or
+                            arp_view.sender_ip_address() != arp.sender_ip_address or
+                            arp_view.target_ethernet_address() != arp.target_ethernet_address or
+                            arp_view.target_ip_address() != arp.target_ip_address,
+                        "ARP view disagrees with message");
+        }
+
+        // receiving a serialized frame is equivalent to receiving the parsed frame
+        {
+            const EthernetAddress local_eth = random_ethernet_address(rd);
+            const EthernetAddress remote_eth = random_ethernet_address(rd);
+            NetworkInterface iface{local_eth, Address("10.0.0.1", 0)};
+
+            ARPMessage request;
+            request.opcode = ARPMessage::OPCODE_REQUEST;
+            request.sender_ethernet_address = remote_eth;
+            request.sender_ip_address = Address("10.0.0.2", 0).ipv4_numeric();
+            request.target_ip_address = Address("10.0.0.3", 0).ipv4_numeric();  // not us
+            const string other_request = EthernetHeader{ETHERNET_BROADCAST, remote_eth, EthernetHeader::TYPE_ARP}
+                                             .serialize() +
+                                         request.serialize();
+            test_err_if(iface.recv_serialized_frame(Buffer{string(other_request)}).has_value(), "unexpected datagram");
+            test_err_if(not iface.frames_out().empty(), "replied to an ARP request for another address");
+
+            request.target_ip_address = Address("10.0.0.1", 0).ipv4_numeric();
+            const string our_request = EthernetHeader{ETHERNET_BROADCAST, remote_eth, EthernetHeader::TYPE_ARP}
+                                           .serialize() +
+                                       request.serialize();
+            iface.recv_serialized_frame(Buffer{string(our_request)});
+            test_err_if(iface.frames_out().size() != 1, "did not reply to an ARP request");
+
+            IPv4Header ip;
+            ip.len = IPv4Header::LENGTH + 5;
+            ip.proto = 17;
+            string dgram = ip.serialize() + "hello";
+            InternetChecksum check;
+            check.add(string_view{dgram}.substr(0, IPv4Header::LENGTH));
+            ip.cksum = check.value();
+            dgram = ip.serialize() + "hello";
+            const string for_us = EthernetHeader{local_eth, remote_eth, EthernetHeader::TYPE_IPv4}.serialize() + dgram;
+            const string for_others =
+                EthernetHeader{remote_eth, remote_eth, EthernetHeader::TYPE_IPv4}.serialize() + dgram;
+            const auto received = iface.recv_serialized_frame(Buffer{string(for_us)});
+            test_err_if(not received.has_value() or received->payload().concatenate() != "hello", "datagram lost");
+            test_err_if(iface.recv_serialized_frame(Buffer{string(for_others)}).has_value(), "accepted other's frame");
+            test_err_if(iface.recv_serialized_frame(Buffer{string("short")}).has_value(), "accepted a runt frame");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
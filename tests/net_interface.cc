@@ -5,6 +5,8 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 
 using namespace std;
 
@@ -313,6 +315,105 @@ int main() {
                            make_arp(ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5").serialize())});
             test.execute(ExpectNoFrame{});
         }
+
+        {
+            const EthernetAddress local_eth = random_private_ethernet_address();
+            NetworkInterfaceTestHarness test{"busy mappings are refreshed", local_eth, Address("4.3.2.1", 0)};
+
+            const EthernetAddress target_eth = random_private_ethernet_address();
+            const auto reply = make_arp(ARPMessage::OPCODE_REPLY, target_eth, "192.168.0.1", local_eth, "4.3.2.1");
+            const auto refresh = make_frame(
+                local_eth,
+                target_eth,
+                EthernetHeader::TYPE_ARP,
+                make_arp(ARPMessage::OPCODE_REQUEST, local_eth, "4.3.2.1", {}, "192.168.0.1").serialize());
+            const auto send_and_expect = [&](const string &dst_ip) {
+                const auto datagram = make_datagram("5.6.7.8", dst_ip);
+                test.execute(SendDatagram{datagram, Address("192.168.0.1", 0)});
+                test.execute(
+                    ExpectFrame{make_frame(local_eth, target_eth, EthernetHeader::TYPE_IPv4, datagram.serialize())});
+            };
+
+            test.execute(
+                ReceiveFrame{make_frame(target_eth, local_eth, EthernetHeader::TYPE_ARP, reply.serialize()), {}});
+            test.execute(Tick{26000});
+            send_and_expect("13.12.11.10");
+            test.execute(ExpectNoFrame{});
+
+            // shortly before expiry, traffic still uses the mapping, and asks the neighbor (once) to confirm it
+            test.execute(Tick{1500});
+            send_and_expect("13.12.11.11");
+            test.execute(ExpectFrame{refresh});
+            test.execute(ExpectNoFrame{});
+            test.execute(Tick{2000});
+            send_and_expect("13.12.11.12");
+            test.execute(ExpectNoFrame{});
+
+            // the reply renews the mapping
+            test.execute(
+                ReceiveFrame{make_frame(target_eth, local_eth, EthernetHeader::TYPE_ARP, reply.serialize()), {}});
+            test.execute(ExpectNoFrame{});
+            test.execute(Tick{3000});
+            send_and_expect("13.12.11.13");
+            test.execute(ExpectNoFrame{});
+
+            // an unanswered refresh lets the mapping expire
+            test.execute(Tick{24500});
+            send_and_expect("13.12.11.14");
+            test.execute(ExpectFrame{refresh});
+            test.execute(Tick{3000});
+            test.execute(SendDatagram{make_datagram("5.6.7.8", "13.12.11.15"), Address("192.168.0.1", 0)});
+            test.execute(ExpectFrame{
+                make_frame(local_eth,
+                           ETHERNET_BROADCAST,
+                           EthernetHeader::TYPE_ARP,
+                           make_arp(ARPMessage::OPCODE_REQUEST, local_eth, "4.3.2.1", {}, "192.168.0.1").serialize())});
+            test.execute(ExpectNoFrame{});
+        }
+
+        {
+            const EthernetAddress local_eth = random_private_ethernet_address();
+            const EthernetAddress remote_eth = random_private_ethernet_address();
+            NetworkInterfaceTestHarness test{
+                "pending datagrams are bounded per neighbor", local_eth, Address("10.0.0.1", 0), 3};
+            const auto request_for = [&](const string &ip) {
+                return make_frame(local_eth,
+                                  ETHERNET_BROADCAST,
+                                  EthernetHeader::TYPE_ARP,
+                                  make_arp(ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, ip).serialize());
+            };
+
+            // a burst toward an unresolved neighbor keeps only the most recent datagrams
+            vector<InternetDatagram> datagrams;
+            for (unsigned int i = 0; i < 5; i++) {
+                datagrams.push_back(make_datagram("10.0.0.1", "1.1.1." + to_string(i)));
+                test.execute(SendDatagram{datagrams.back(), Address("10.0.0.2", 0)});
+            }
+            test.execute(ExpectFrame{request_for("10.0.0.2")});
+            test.execute(ExpectNoFrame{});
+            test.execute(ExpectDroppedDatagrams{2});
+
+            // another neighbor has a queue of its own
+            const auto other_datagram = make_datagram("10.0.0.1", "2.2.2.2");
+            test.execute(SendDatagram{other_datagram, Address("10.0.0.3", 0)});
+            test.execute(ExpectFrame{request_for("10.0.0.3")});
+            test.execute(ExpectDroppedDatagrams{2});
+
+            // the reply releases that neighbor's datagrams, in order, and nobody else's
+            test.execute(ReceiveFrame{
+                make_frame(
+                    remote_eth,
+                    local_eth,
+                    EthernetHeader::TYPE_ARP,
+                    make_arp(ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.2", local_eth, "10.0.0.1").serialize()),
+                {}});
+            for (unsigned int i = 2; i < 5; i++) {
+                test.execute(ExpectFrame{
+                    make_frame(local_eth, remote_eth, EthernetHeader::TYPE_IPv4, datagrams[i].serialize())});
+            }
+            test.execute(ExpectNoFrame{});
+            test.execute(ExpectDroppedDatagrams{2});
+        }
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return EXIT_FAILURE;
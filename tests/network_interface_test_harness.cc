@@ -51,12 +51,14 @@ NetworkInterfaceAction::~NetworkInterfaceAction() {}
 
 NetworkInterfaceTestHarness::NetworkInterfaceTestHarness(const std::string &test_name,
                                                          const EthernetAddress &ethernet_address,
-                                                         const Address &ip_address)
-    : _test_name(test_name), _interface(ethernet_address, ip_address) {
+                                                         const Address &ip_address,
+                                                         const size_t max_pending_datagrams)
+    : _test_name(test_name), _interface(ethernet_address, ip_address, max_pending_datagrams) {
     std::ostringstream ss;
     ss << "Initialized with ("
        << "ethernet_address=" << to_string(ethernet_address) << ", "
-       << "ip_address=" << ip_address.ip() << ")";
+       << "ip_address=" << ip_address.ip() << ", "
+       << "max_pending_datagrams=" << max_pending_datagrams << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
@@ -167,6 +169,14 @@ void ExpectNoFrame::execute(NetworkInterface &interface) const {
     }
 }
 
+string ExpectDroppedDatagrams::description() const { return to_string(count) + " datagrams dropped in all"; }
+
+void ExpectDroppedDatagrams::execute(NetworkInterface &interface) const {
+    if (interface.dropped_datagrams() != count) {
+        throw NetworkInterfaceExpectationViolation::property("dropped_datagrams", count, interface.dropped_datagrams());
+    }
+}
+
 string Tick::description() const { return to_string(_ms) + " ms pass"; }
 
 void Tick::execute(NetworkInterface &interface) const { interface.tick(_ms); }
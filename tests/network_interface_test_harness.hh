@@ -69,6 +69,15 @@ struct ExpectNoFrame : public NetworkInterfaceExpectation {
     void execute(NetworkInterface &interface) const override;
 };
 
+struct ExpectDroppedDatagrams : public NetworkInterfaceExpectation {
+    size_t count;
+
+    std::string description() const override;
+    void execute(NetworkInterface &interface) const override;
+
+    ExpectDroppedDatagrams(const size_t c) : count(c) {}
+};
+
 struct Tick : public NetworkInterfaceAction {
     size_t _ms;
 
@@ -86,7 +95,8 @@ class NetworkInterfaceTestHarness {
   public:
     NetworkInterfaceTestHarness(const std::string &test_name,
                                 const EthernetAddress &ethernet_address,
-                                const Address &ip_address);
+                                const Address &ip_address,
+                                const size_t max_pending_datagrams = NetworkInterface::DEFAULT_MAX_PENDING_DATAGRAMS);
 
     void execute(const NetworkInterfaceTestStep &step);
 };
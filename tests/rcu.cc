@@ -0,0 +1,122 @@
+#include "rcu.hh"
+#include "test_err_if.hh"
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//! A value whose two halves must always match
+struct Pair {
+    uint64_t first;
+    uint64_t second;
+};
+
+//! Counts how many times it has been copied
+struct Counted {
+    static unsigned int copies;
+    unsigned int value{0};
+
+    Counted() = default;
+    Counted(const Counted &other) : value(other.value) { copies++; }
+    Counted &operator=(const Counted &other) = delete;
+};
+
+unsigned int Counted::copies = 0;
+
+int main() {
+    try {
+        // readers see the latest value; a value is freed once no guard pins it
+        {
+            RCU<vector<int>> rcu{make_unique<vector<int>>(1, 1)};
+            auto &reader = rcu.add_reader();
+            {
+                const auto value = rcu.read(reader);
+                test_err_if(value->size() != 1 or value->front() != 1, "wrong initial value");
+
+                rcu.update([](vector<int> &next) { next.push_back(2); });
+                test_err_if(value->size() != 1, "pinned value changed");
+                test_err_if(rcu.reclaim() != 1, "pinned value was freed");
+            }
+            test_err_if(rcu.reclaim() != 0, "unpinned value was not freed");
+            test_err_if(rcu.read(reader)->size() != 2, "update was not published");
+
+            // a guard taken after an update does not hold back the value it replaced
+            const auto value = rcu.read(reader);
+            rcu.update([](vector<int> &next) { next.push_back(3); });
+            rcu.update([](vector<int> &next) { next.push_back(4); });
+            test_err_if(rcu.reclaim() != 2, "pinned value was freed");
+        }
+
+        // a change that throws publishes nothing
+        {
+            RCU<vector<int>> rcu{make_unique<vector<int>>()};
+            auto &reader = rcu.add_reader();
+            bool threw = false;
+            try {
+                rcu.update([](vector<int> &next) {
+                    next.push_back(1);
+                    throw runtime_error("failed change");
+                });
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_err_if(not threw or not rcu.read(reader)->empty(), "failed change was published");
+        }
+
+        // until a reader is registered, updates change the value in place; from then on, a copy
+        {
+            RCU<Counted> rcu{make_unique<Counted>()};
+            for (unsigned int i = 0; i < 100; i++) {
+                rcu.update([](Counted &next) { next.value++; });
+            }
+            test_err_if(Counted::copies != 0, "value was copied with no reader");
+            auto &reader = rcu.add_reader();
+            test_err_if(rcu.read(reader)->value != 100, "changes made in place were lost");
+            rcu.update([](Counted &next) { next.value++; });
+            test_err_if(Counted::copies != 1 or rcu.read(reader)->value != 101, "value was not copied for a reader");
+        }
+
+        // readers on other threads never see a value being changed, or one that has been freed
+        {
+            RCU<Pair> rcu{make_unique<Pair>(Pair{0, 0})};
+            atomic<bool> done{false};
+            vector<thread> readers;
+            for (unsigned int i = 0; i < 3; i++) {
+                auto &reader = rcu.add_reader();
+                readers.emplace_back([&] {
+                    uint64_t last = 0;
+                    while (not done.load()) {
+                        const auto value = rcu.read(reader);
+                        if (value->first != value->second or value->first < last) {
+                            abort();
+                        }
+                        last = value->first;
+                    }
+                });
+            }
+            for (uint64_t i = 1; i <= 20000; i++) {
+                rcu.update([&](Pair &next) {
+                    next.first = i;
+                    next.second = i;
+                });
+            }
+            done = true;
+            for (auto &t : readers) {
+                t.join();
+            }
+            test_err_if(rcu.reclaim() != 0, "values were not freed");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+#include "arp_message.hh"
+#include "ethernet_header.hh"
+#include "ipv4_datagram.hh"
+#include "parallel_router.hh"
+#include "test_err_if.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+constexpr size_t num_interfaces = 3;
+constexpr unsigned int datagrams_per_host = 500;
+
+EthernetAddress private_ethernet_address(const uint8_t n) { return {0x02, 0, 0, 0, 0, n}; }
+
+uint32_t router_ip(const size_t n) { return Address("10.0." + to_string(n) + ".1", 0).ipv4_numeric(); }
+uint32_t host_ip(const size_t n) { return Address("10.0." + to_string(n) + ".2", 0).ipv4_numeric(); }
+
+EthernetAddress router_eth(const size_t n) { return private_ethernet_address(static_cast<uint8_t>(n)); }
+EthernetAddress host_eth(const size_t n) { return private_ethernet_address(static_cast<uint8_t>(100 + n)); }
+
+EthernetFrame make_frame(const size_t n, const uint16_t type, BufferList &&payload) {
+    EthernetFrame frame;
+    frame.header().src = host_eth(n);
+    frame.header().dst = type == EthernetHeader::TYPE_ARP ? ETHERNET_BROADCAST : router_eth(n);
+    frame.header().type = type;
+    frame.payload() = payload.concatenate();
+    return frame;
+}
+
+//! An ARP request from host `n` for the router, which teaches the router the host's address
+EthernetFrame make_arp_request(const size_t n) {
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REQUEST;
+    arp.sender_ethernet_address = host_eth(n);
+    arp.sender_ip_address = host_ip(n);
+    arp.target_ip_address = router_ip(n);
+    return make_frame(n, EthernetHeader::TYPE_ARP, arp.serialize());
+}
+
+//! The `seq`th datagram from host `src` to host `dst`
+EthernetFrame make_datagram_frame(const size_t src, const size_t dst, const unsigned int seq, const uint8_t ttl = 64) {
+    InternetDatagram dgram;
+    dgram.header().src = host_ip(src);
+    dgram.header().dst = host_ip(dst);
+    dgram.header().ttl = ttl;
+    dgram.payload() = to_string(src) + " " + to_string(seq);
+    dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+    return make_frame(src, EthernetHeader::TYPE_IPv4, dgram.serialize());
+}
+
+void push(ParallelRouter &router, const size_t n, EthernetFrame &&frame) {
+    while (not router.push_frame(n, move(frame))) {
+        this_thread::yield();
+    }
+}
+
+int main() {
+    try {
+        ParallelRouter router;
+        for (size_t n = 0; n < num_interfaces; n++) {
+            router.add_interface(NetworkInterface(router_eth(n), Address::from_ipv4_numeric(router_ip(n))));
+            router.add_route(host_ip(n) & 0xffffff00, 24, {}, n);
+        }
+
+        router.start();
+
+        // meanwhile another thread keeps adding unrelated routes (to 172.16.x.y/32), which must not disturb routing
+        atomic<bool> churning{true};
+        thread churn([&] {
+            for (uint32_t i = 0; i < 2000 and churning.load(); i++) {
+                router.add_route(Address("172.16.0.0", 0).ipv4_numeric() + i, 32, {}, i % num_interfaces);
+            }
+        });
+
+        for (size_t n = 0; n < num_interfaces; n++) {
+            push(router, n, make_arp_request(n));
+        }
+
+        // every host sends to the next one; a datagram that would expire, and one with no route, are dropped
+        for (size_t n = 0; n < num_interfaces; n++) {
+            push(router, n, make_datagram_frame(n, (n + 1) % num_interfaces, 0, 1));
+            InternetDatagram unroutable;
+            unroutable.header().src = host_ip(n);
+            unroutable.header().dst = Address("192.168.0.1", 0).ipv4_numeric();
+            unroutable.header().len = unroutable.header().hlen * 4;
+            push(router, n, make_frame(n, EthernetHeader::TYPE_IPv4, unroutable.serialize()));
+        }
+
+        // meanwhile the owner collects what each interface sends, checking the order from each source
+        array<unsigned int, num_interfaces> received{};
+        array<unsigned int, num_interfaces> pushed{};
+        const auto deadline = chrono::steady_clock::now() + chrono::seconds(30);
+        while (any_of(received.begin(), received.end(), [](const unsigned int r) { return r < datagrams_per_host; })) {
+            test_err_if(chrono::steady_clock::now() > deadline, "datagrams were not delivered");
+            for (size_t n = 0; n < num_interfaces; n++) {
+                if (pushed[n] < datagrams_per_host) {
+                    if (router.push_frame(n, make_datagram_frame(n, (n + 1) % num_interfaces, pushed[n] + 1))) {
+                        pushed[n]++;
+                    }
+                }
+
+                for (auto frame = router.pop_frame(n); frame.has_value(); frame = router.pop_frame(n)) {
+                    if (frame->header().type != EthernetHeader::TYPE_IPv4) {
+                        continue;  // the ARP replies
+                    }
+                    InternetDatagram dgram;
+                    test_err_if(dgram.parse(frame->payload().concatenate()) != ParseResult::NoError,
+                                "bad datagram");
+                    test_err_if(frame->header().dst != host_eth(n), "sent to the wrong Ethernet address");
+                    test_err_if(dgram.header().dst != host_ip(n), "sent from the wrong interface");
+                    test_err_if(dgram.header().ttl != 63, "TTL was not decremented");
+                    const size_t src = (n + num_interfaces - 1) % num_interfaces;
+                    const string expected = to_string(src) + " " + to_string(received[n] + 1);
+                    test_err_if(dgram.payload().concatenate() != expected, "datagrams arrived out of order");
+                    received[n]++;
+                }
+            }
+        }
+
+        churning = false;
+        churn.join();
+
+        // a route added while running is used: a datagram to a directly attached network makes
+        // the interface ask for the destination's Ethernet address
+        router.add_route(Address("172.31.0.0", 0).ipv4_numeric(), 16, {}, 2);
+        InternetDatagram to_new_route;
+        to_new_route.header().src = host_ip(0);
+        to_new_route.header().dst = Address("172.31.0.5", 0).ipv4_numeric();
+        to_new_route.header().len = to_new_route.header().hlen * 4;
+        push(router, 0, make_frame(0, EthernetHeader::TYPE_IPv4, to_new_route.serialize()));
+        optional<EthernetFrame> arp_request;
+        while (not arp_request.has_value()) {
+            test_err_if(chrono::steady_clock::now() > deadline, "new route was not used");
+            arp_request = router.pop_frame(2);
+            this_thread::yield();
+        }
+        ARPMessage arp;
+        test_err_if(arp.parse(arp_request->payload().concatenate()) != ParseResult::NoError, "bad ARP message");
+        test_err_if(arp.target_ip_address != to_new_route.header().dst, "asked for the wrong address");
+
+        router.stop();
+        test_err_if(router.dropped_datagrams() != 0, "dropped datagrams");
+        for (size_t n = 0; n < num_interfaces; n++) {
+            test_err_if(router.pop_frame(n).has_value(), "extra frame");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
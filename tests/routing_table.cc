@@ -0,0 +1,138 @@
+#include "routing_table.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! A datagram of protocol `proto` whose payload starts with the given ports
+static InternetDatagram make_datagram(const uint32_t src,
+                                      const uint32_t dst,
+                                      const uint8_t proto,
+                                      const uint16_t src_port,
+                                      const uint16_t dst_port) {
+    InternetDatagram dgram;
+    dgram.header().src = src;
+    dgram.header().dst = dst;
+    dgram.header().proto = proto;
+    string payload(20, 0);
+    payload[0] = static_cast<char>(src_port >> 8);
+    payload[1] = static_cast<char>(src_port & 0xff);
+    payload[2] = static_cast<char>(dst_port >> 8);
+    payload[3] = static_cast<char>(dst_port & 0xff);
+    dgram.payload() = move(payload);
+    dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+    return dgram;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const uint32_t dst = 0x0a010203;
+
+        // a single path is always taken
+        {
+            RoutingTable table;
+            table.add_route(0x0a000000, 8, {}, 2);
+            const uint32_t route = table.lookup(dst);
+            test_err_if(route == ForwardingTable::NO_ROUTE, "no route");
+            const auto &path = RoutingTable::path(table.route(route), make_datagram(1, dst, 6, 1, 2));
+            test_err_if(path.interface_num != 2, "wrong path");
+            test_err_if(RoutingTable::next_hop(path, dst) != dst, "wrong next hop");
+        }
+
+        // the same prefix again adds a path to the same route; a zero weight is refused
+        RoutingTable table;
+        table.add_route(0x0a000000, 8, Address{"192.168.0.1"}, 0);
+        table.add_route(0x0a0000ff, 8, Address{"192.168.1.1"}, 1, 3);  // host bits are ignored
+        table.add_route(0x0a010000, 16, Address{"192.168.2.1"}, 2);
+        test_err_if(table.lookup(0x0a020000) != 0 or table.lookup(dst) != 1, "wrong route");
+        const auto &route = table.route(0);
+        test_err_if(route.paths.size() != 2 or route.total_weight != 4, "path was not added");
+        test_err_if(RoutingTable::next_hop(route.paths[1], dst) != Address{"192.168.1.1"}.ipv4_numeric(),
+                    "wrong next hop");
+        bool threw = false;
+        try {
+            table.add_route(0x0a000000, 8, {}, 0, 0);
+        } catch (const runtime_error &) {
+            threw = true;
+        }
+        test_err_if(not threw, "added a path with zero weight");
+
+        // a flow always takes the same path, and flows spread over the paths by weight
+        {
+            array<unsigned int, 2> flows{};
+            for (unsigned int i = 0; i < 10000; i++) {
+                const auto src = static_cast<uint32_t>(rd());
+                const auto src_port = static_cast<uint16_t>(rd());
+                const uint8_t proto = i % 2 ? IPv4Header::PROTO_TCP : IPv4Header::PROTO_UDP;
+                const auto &path = RoutingTable::path(route, make_datagram(src, 0x0a020304, proto, src_port, 80));
+                for (unsigned int j = 0; j < 4; j++) {
+                    const auto &again = RoutingTable::path(route, make_datagram(src, 0x0a020304, proto, src_port, 80));
+                    test_err_if(&again != &path, "flow changed paths");
+                }
+                flows[path.interface_num]++;
+            }
+            test_err_if(flows[1] < 7000 or flows[1] > 8000, "flows not spread by weight: " + to_string(flows[1]));
+        }
+
+        // adding a path moves only the flows it takes over: about 1/N of them, with N paths
+        for (size_t paths = 2; paths <= 8; paths++) {
+            RoutingTable spread;
+            for (size_t i = 0; i + 1 < paths; i++) {
+                spread.add_route(0x0a000000, 8, {}, i);
+            }
+            vector<InternetDatagram> datagrams;
+            vector<size_t> before;
+            for (unsigned int i = 0; i < 10000; i++) {
+                datagrams.push_back(make_datagram(static_cast<uint32_t>(rd()), dst, IPv4Header::PROTO_TCP, 1000, 80));
+                before.push_back(RoutingTable::path(spread.route(0), datagrams.back()).interface_num);
+            }
+            spread.add_route(0x0a000000, 8, {}, paths - 1);
+            unsigned int moved = 0;
+            for (unsigned int i = 0; i < datagrams.size(); i++) {
+                const size_t after = RoutingTable::path(spread.route(0), datagrams[i]).interface_num;
+                if (after != before[i]) {
+                    test_err_if(after != paths - 1, "a flow moved between old paths");
+                    moved++;
+                }
+            }
+            const unsigned int expected = 10000 / paths;
+            test_err_if(moved < expected * 9 / 10 or moved > expected * 11 / 10,
+                        "adding path " + to_string(paths) + " moved " + to_string(moved) + " flows");
+        }
+
+        // ports count for TCP and UDP, but not for other protocols or for fragments
+        {
+            const auto hash = [](const InternetDatagram &dgram) { return RoutingTable::flow_hash(dgram); };
+            const auto tcp = make_datagram(1, dst, IPv4Header::PROTO_TCP, 1000, 80);
+            test_err_if(hash(tcp) != hash(make_datagram(1, dst, IPv4Header::PROTO_TCP, 1000, 80)), "unstable hash");
+            unsigned int same = 0;
+            for (uint16_t port = 1001; port < 1101; port++) {
+                same += hash(tcp) == hash(make_datagram(1, dst, IPv4Header::PROTO_TCP, port, 80));
+                test_err_if(hash(make_datagram(1, dst, 1, port, 80)) != hash(make_datagram(1, dst, 1, 1000, 80)),
+                            "ports count for ICMP");
+                auto fragment = make_datagram(1, dst, IPv4Header::PROTO_UDP, port, 80);
+                fragment.header().mf = true;
+                auto first_fragment = make_datagram(1, dst, IPv4Header::PROTO_UDP, 1000, 80);
+                first_fragment.header().mf = true;
+                test_err_if(hash(fragment) != hash(first_fragment), "ports count for fragments");
+            }
+            test_err_if(same > 1, "ports do not count for TCP");
+            test_err_if(hash(tcp) == hash(make_datagram(1, dst, IPv4Header::PROTO_UDP, 1000, 80)),
+                        "protocol does not count");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
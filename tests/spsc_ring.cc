@@ -0,0 +1,79 @@
+#include "spsc_ring.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+int main() {
+    try {
+        // capacity is rounded up to a power of two
+        test_err_if(SPSCRing<int>{1}.capacity() != 1, "wrong capacity");
+        test_err_if(SPSCRing<int>{1000}.capacity() != 1024, "wrong capacity");
+
+        // first in, first out, up to the capacity
+        {
+            SPSCRing<string> ring{4};
+            test_err_if(ring.pop().has_value(), "empty ring popped an element");
+            for (unsigned int i = 0; i < 4; i++) {
+                test_err_if(not ring.push(to_string(i)), "push failed before the ring was full");
+            }
+            string extra{"extra"};
+            test_err_if(ring.push(move(extra)), "push succeeded on a full ring");
+            test_err_if(extra != "extra", "failed push moved from its argument");
+
+            test_err_if(ring.pop() != "0", "wrong element");
+            test_err_if(not ring.push(move(extra)), "push failed after a pop");
+            for (const string expected : {"1", "2", "3", "extra"}) {
+                test_err_if(ring.pop() != expected, "wrong element");
+            }
+            test_err_if(ring.pop().has_value(), "empty ring popped an element");
+        }
+
+        // popping releases the ring's copy of the element
+        {
+            SPSCRing<shared_ptr<int>> ring{2};
+            auto value = make_shared<int>(7);
+            ring.push(shared_ptr<int>{value});
+            test_err_if(value.use_count() != 2, "ring does not hold the element");
+            ring.pop();
+            test_err_if(value.use_count() != 1, "ring still holds a popped element");
+        }
+
+        // elements cross between threads intact and in order, through a ring much smaller than the stream
+        {
+            constexpr unsigned int count = 1000000;
+            SPSCRing<unsigned int> ring{64};
+            thread producer([&] {
+                for (unsigned int i = 0; i < count; i++) {
+                    unsigned int value = i;
+                    while (not ring.push(move(value))) {
+                        this_thread::yield();
+                    }
+                }
+            });
+            unsigned int expected = 0;
+            while (expected < count) {
+                const auto value = ring.pop();
+                if (not value.has_value()) {
+                    this_thread::yield();
+                    continue;
+                }
+                test_err_if(value.value() != expected, "elements arrived out of order");
+                expected++;
+            }
+            producer.join();
+            test_err_if(ring.pop().has_value(), "extra element");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include "tcp_connection.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static vector<TCPSegment> drain(TCPConnection &conn) {
+    vector<TCPSegment> segs;
+    while (not conn.segments_out().empty()) {
+        segs.push_back(move(conn.segments_out().front()));
+        conn.segments_out().pop();
+    }
+    return segs;
+}
+
+//! Two connections that have completed the handshake, with nothing outstanding
+static void handshake(TCPConnection &client, TCPConnection &server) {
+    client.connect();
+    server.segments_received(drain(client));
+    client.segments_received(drain(server));
+    server.segments_received(drain(client));
+    test_err_if(not client.segments_out().empty() or not server.segments_out().empty(), "handshake left segments");
+}
+
+int main() {
+    try {
+        TCPConfig cfg{};
+
+        // a burst of data segments is acknowledged once, up to the end of the burst
+        {
+            TCPConnection client{cfg}, server{cfg};
+            handshake(client, server);
+
+            vector<TCPSegment> burst;
+            for (unsigned int i = 0; i < 8; i++) {
+                client.write(string(100, 'a' + i));
+                auto segs = drain(client);
+                burst.insert(burst.end(), segs.begin(), segs.end());
+            }
+            test_err_if(burst.size() != 8, "expected one segment per write");
+
+            server.segments_received(burst);
+            const vector<TCPSegment> acks = drain(server);
+            test_err_if(acks.size() != 1, "expected one ACK for the burst, got " + to_string(acks.size()));
+            test_err_if(acks.front().header().ackno != client.next_seqno(), "ACK does not cover the burst");
+            test_err_if(server.inbound_stream().buffer_size() != 800, "data lost");
+
+            client.segments_received(acks);
+            test_err_if(client.bytes_in_flight() != 0, "client still has data in flight");
+        }
+
+        // segments delivered out of order within a burst still produce one (cumulative) ACK
+        {
+            TCPConnection client{cfg}, server{cfg};
+            handshake(client, server);
+
+            vector<TCPSegment> burst;
+            for (unsigned int i = 0; i < 4; i++) {
+                client.write("segment " + to_string(i));
+                auto segs = drain(client);
+                burst.insert(burst.begin(), segs.begin(), segs.end());
+            }
+            server.segments_received(burst);
+            const vector<TCPSegment> acks = drain(server);
+            test_err_if(acks.size() != 1, "expected one ACK for the reordered burst");
+            test_err_if(acks.front().header().ackno != client.next_seqno(), "ACK does not cover the burst");
+            test_err_if(server.inbound_stream().read(100) != "segment 0segment 1segment 2segment 3", "data garbled");
+        }
+
+        // a RST in the middle of a burst aborts the connection, and nothing is sent
+        {
+            TCPConnection client{cfg}, server{cfg};
+            handshake(client, server);
+            client.write("doomed");
+            vector<TCPSegment> burst = drain(client);
+            TCPSegment rst;
+            rst.header().rst = true;
+            rst.header().seqno = client.next_seqno();
+            burst.push_back(rst);
+            client.write("ignored");
+            const vector<TCPSegment> after = drain(client);
+            burst.insert(burst.end(), after.begin(), after.end());
+
+            server.segments_received(burst);
+            test_err_if(server.active(), "RST did not abort the connection");
+            test_err_if(not server.segments_out().empty(), "sent a segment after the RST");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
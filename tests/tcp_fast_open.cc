@@ -0,0 +1,247 @@
+#include "tcp_connection.hh"
+#include "tcp_fast_open_cache.hh"
+#include "tcp_listener.hh"
+#include "tcp_over_ip.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static const TCPFourTuple server_tuple{0x0a000001, 80, 0x0a000002, 4000};
+static constexpr uint32_t server_address = 0x0a000001;
+
+//! Pass a segment through serialization and parsing, as the network would
+static TCPSegment over_the_wire(const TCPSegment &seg) {
+    TCPSegment parsed;
+    test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError, "segment failed to parse");
+    return parsed;
+}
+
+static TCPSegment client_segment(TCPConnection &client) {
+    test_err_if(client.segments_out().empty(), "client sent nothing");
+    const TCPSegment seg = over_the_wire(client.segments_out().front());
+    client.segments_out().pop();
+    return seg;
+}
+
+static TCPSegment server_segment(TCPListener &listener) {
+    test_err_if(listener.segments_out().empty(), "server sent nothing");
+    const TCPSegment seg = over_the_wire(listener.segments_out().front().second);
+    listener.segments_out().pop();
+    return seg;
+}
+
+int main() {
+    try {
+        // the option survives serialization, alongside a payload
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().fast_open_cookie = string("\x01\x02\x03\x04\x05\x06", 6);
+            seg.payload() = string("hello");
+            const TCPSegment parsed = over_the_wire(seg);
+            test_err_if(parsed.header().doff != 7, "options not accounted for in doff");
+            test_err_if(parsed.header().fast_open_cookie != seg.header().fast_open_cookie, "cookie changed");
+            test_err_if(parsed.payload().copy() != "hello", "payload changed");
+
+            seg.header().fast_open_cookie = string{};
+            test_err_if(over_the_wire(seg).header().fast_open_cookie != string{}, "cookie request lost");
+        }
+
+        // cookies must be 4 to 16 bytes long (or empty, to request one); an option with any other length is ignored
+        for (size_t length = 0; length <= 20; length++) {
+            TCPSegment seg;
+            seg.header().syn = true;
+            string raw = seg.serialize().concatenate();
+            raw.push_back(static_cast<char>(TCPHeader::OPTION_FAST_OPEN));
+            raw.push_back(static_cast<char>(2 + length));
+            raw += string(length, 'c');
+            raw.resize((raw.size() + 3) / 4 * 4, static_cast<char>(TCPHeader::OPTION_END));
+            raw[12] = static_cast<char>((raw.size() / 4) << 4);  // data offset
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(move(raw), 0, false) != ParseResult::NoError, "segment failed to parse");
+            const bool valid = length == 0 or (length >= 4 and length <= 16);
+            test_err_if(parsed.header().fast_open_cookie.has_value() != valid,
+                        "cookie of length " + to_string(length) + " wrongly " + (valid ? "ignored" : "accepted"));
+        }
+        {
+            TCPSegment seg;
+            seg.header().fast_open_cookie = string(3, 'x');
+            bool threw = false;
+            try {
+                seg.serialize();
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_err_if(not threw, "serialized a cookie of invalid length");
+        }
+
+        // a SYN with the option fits in an IPv4 datagram, whose length counts the option
+        {
+            TCPOverIPv4Adapter adapter;
+            adapter.config_mut().source = {"10.0.0.1", 1234};
+            adapter.config_mut().destination = {"10.0.0.2", 80};
+            for (const string &cookie : {string{}, string("\x01\x02\x03\x04\x05\x06\x07\x08", 8)}) {
+                TCPSegment seg;
+                seg.header().syn = true;
+                seg.header().fast_open_cookie = cookie;
+                seg.payload() = string("hello");
+                const InternetDatagram dgram = adapter.wrap_tcp_in_ip(seg);
+
+                InternetDatagram parsed_dgram;
+                test_err_if(parsed_dgram.parse(dgram.serialize().concatenate()) != ParseResult::NoError,
+                            "datagram failed to parse");
+                TCPSegment parsed;
+                test_err_if(parsed.parse(parsed_dgram.payload().concatenate(), parsed_dgram.header().pseudo_cksum()) !=
+                                ParseResult::NoError,
+                            "segment failed to parse");
+                test_err_if(parsed.header().fast_open_cookie != cookie, "cookie changed");
+                test_err_if(parsed.payload().copy() != "hello", "payload changed");
+            }
+        }
+
+        TCPConfig cfg{};
+        TCPListenerConfig listener_cfg{};
+        listener_cfg.fast_open = true;
+        listener_cfg.fast_open_backlog = 1;
+        TCPListener listener{cfg, listener_cfg};
+        TCPFastOpenCache cache;
+
+        // first connection: the client asks for a cookie, and the data waits for the handshake
+        {
+            TCPConfig client_cfg = cfg;
+            client_cfg.fast_open_cookie = cache.cookie_for(server_address);
+            TCPConnection client{client_cfg};
+            client.write("first request");
+            const TCPSegment syn = client_segment(client);
+            test_err_if(syn.header().fast_open_cookie != string{}, "SYN should request a cookie");
+            test_err_if(syn.payload().size() != 0, "SYN carried data without a cookie");
+
+            listener.segment_received(server_tuple, syn);
+            const TCPSegment syn_ack = server_segment(listener);
+            test_err_if(not syn_ack.header().fast_open_cookie.has_value() or syn_ack.header().fast_open_cookie->empty(),
+                        "SYN/ACK did not carry a cookie");
+
+            client.segment_received(syn_ack);
+            test_err_if(client.fast_open_cookie() != syn_ack.header().fast_open_cookie, "client did not learn cookie");
+            cache.store(server_address, client.fast_open_cookie().value());
+
+            const TCPSegment data = client_segment(client);
+            test_err_if(data.payload().copy() != "first request", "client did not send data after handshake");
+            listener.segment_received(server_tuple, data);
+            test_err_if(listener.accept() != server_tuple, "connection not accepted");
+            test_err_if(listener.inbound_stream(server_tuple).read(100) != "first request", "data lost");
+
+            // shut down
+            client.end_input_stream();
+            listener.segment_received(server_tuple, client_segment(client));
+            listener.end_input_stream(server_tuple);
+            while (not listener.segments_out().empty()) {
+                client.segment_received(server_segment(listener));
+            }
+            while (not client.segments_out().empty()) {
+                listener.segment_received(server_tuple, client_segment(client));
+            }
+            listener.tick(1);
+            test_err_if(listener.has_connection(server_tuple), "server side did not close");
+        }
+
+        // second connection: the cached cookie lets the SYN carry the request
+        {
+            TCPConfig client_cfg = cfg;
+            client_cfg.fast_open_cookie = cache.cookie_for(server_address);
+            TCPConnection client{client_cfg};
+            client.write("second request");
+            const TCPSegment syn = client_segment(client);
+            test_err_if(syn.payload().copy() != "second request", "SYN did not carry data");
+
+            listener.segment_received(server_tuple, syn);
+            test_err_if(listener.accept() != server_tuple, "connection not accepted at the SYN");
+            test_err_if(listener.inbound_stream(server_tuple).read(100) != "second request", "SYN data lost");
+
+            const TCPSegment syn_ack = server_segment(listener);
+            test_err_if(syn_ack.header().ackno != syn.header().seqno + 15, "SYN/ACK did not acknowledge data");
+            client.segment_received(syn_ack);
+            test_err_if(client.bytes_in_flight() != 0, "client still has data in flight");
+            test_err_if(client.state() != TCPState::State::ESTABLISHED, "client not established");
+
+            listener.segment_received(server_tuple, client_segment(client));
+            test_err_if(listener.connection(server_tuple).state() != TCPState::State::ESTABLISHED,
+                        "server not established");
+        }
+
+        // a bad cookie: the data is ignored, and sent again once the handshake is done
+        {
+            const TCPFourTuple tuple{0x0a000001, 80, 0x0a000003, 4000};
+            TCPConfig client_cfg = cfg;
+            client_cfg.fast_open_cookie = cache.cookie_for(server_address);  // issued to a different address
+            TCPConnection client{client_cfg};
+            client.write("third request");
+
+            const TCPSegment syn = client_segment(client);
+            test_err_if(syn.payload().copy() != "third request", "SYN did not carry data");
+            listener.segment_received(tuple, syn);
+            test_err_if(listener.has_connection(tuple), "bad cookie accepted");
+
+            const TCPSegment syn_ack = server_segment(listener);
+            test_err_if(syn_ack.header().ackno != syn.header().seqno + 1, "SYN/ACK acknowledged refused data");
+            test_err_if(syn_ack.header().fast_open_cookie == cache.cookie_for(server_address),
+                        "expected a fresh cookie");
+            client.segment_received(syn_ack);
+
+            const TCPSegment data = client_segment(client);
+            test_err_if(data.header().syn or data.payload().copy() != "third request", "data not resent");
+            test_err_if(data.header().seqno != syn.header().seqno + 1, "resent data has wrong seqno");
+            listener.segment_received(tuple, data);
+            test_err_if(listener.accept() != tuple, "connection not accepted");
+            test_err_if(listener.inbound_stream(tuple).read(100) != "third request", "resent data lost");
+            test_err_if(not client.segments_out().empty(), "client sent too much");
+        }
+
+        // only fast_open_backlog connections may be accepted by Fast Open before their handshakes finish
+        {
+            listener.segments_out() = {};  // acknowledgments for the connections above
+            const TCPFourTuple first{0x0a000001, 80, 0x0a000002, 4001};
+            const TCPFourTuple second{0x0a000001, 80, 0x0a000002, 4002};
+            TCPConfig client_cfg = cfg;
+            client_cfg.fast_open_cookie = cache.cookie_for(server_address);
+            TCPConnection first_client{client_cfg};
+            TCPConnection second_client{client_cfg};
+            first_client.write("fourth request");
+            second_client.write("fifth request");
+
+            listener.segment_received(first, client_segment(first_client));
+            test_err_if(listener.accept() != first, "connection not accepted at the SYN");
+            test_err_if(listener.fast_open_pending() != 1, "Fast Open handshake not counted");
+            const TCPSegment first_syn_ack = server_segment(listener);
+
+            listener.segment_received(second, client_segment(second_client));
+            test_err_if(listener.has_connection(second), "accepted more Fast Open handshakes than allowed");
+            const TCPSegment second_syn_ack = server_segment(listener);
+            second_client.segment_received(second_syn_ack);
+            test_err_if(client_segment(second_client).payload().copy() != "fifth request", "data not resent");
+
+            // once the first handshake finishes, another SYN's data is accepted
+            first_client.segment_received(first_syn_ack);
+            listener.segment_received(first, client_segment(first_client));
+            test_err_if(listener.fast_open_pending() != 0, "finished handshake still counted");
+            TCPConnection third_client{client_cfg};
+            third_client.write("sixth request");
+            const TCPFourTuple third{0x0a000001, 80, 0x0a000002, 4003};
+            listener.segment_received(third, client_segment(third_client));
+            test_err_if(listener.accept() != third, "connection not accepted at the SYN");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,263 @@
+#include "tcp_listener.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+static TCPFourTuple connection_tuple(const uint16_t remote_port) { return {0x0a000001, 80, 0x0a000002, remote_port}; }
+
+static TCPSegment make_syn(const WrappingInt32 isn) {
+    TCPSegment seg;
+    seg.header().syn = true;
+    seg.header().seqno = isn;
+    seg.header().win = 1000;
+    return seg;
+}
+
+static TCPSegment make_ack(const WrappingInt32 seqno, const WrappingInt32 ackno, const string &payload = "") {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().seqno = seqno;
+    seg.header().ackno = ackno;
+    seg.header().win = 1000;
+    seg.payload() = string(payload);
+    return seg;
+}
+
+//! Pop the next outbound segment, checking that it belongs to `tuple`
+static TCPSegment expect_segment(TCPListener &listener, const TCPFourTuple &tuple, const string &what) {
+    test_err_if(listener.segments_out().empty(), "expected " + what + " but no segment was sent");
+    const auto [seg_tuple, seg] = listener.segments_out().front();
+    listener.segments_out().pop();
+    test_err_if(seg_tuple != tuple, what + " was sent to the wrong connection");
+    return seg;
+}
+
+static TCPSegment expect_syn_ack(TCPListener &listener, const TCPFourTuple &tuple, const WrappingInt32 peer_isn) {
+    const TCPSegment seg = expect_segment(listener, tuple, "SYN/ACK");
+    test_err_if(not seg.header().syn or not seg.header().ack, "expected SYN/ACK");
+    test_err_if(seg.header().ackno != peer_isn + 1, "SYN/ACK has wrong ackno");
+    return seg;
+}
+
+static void expect_no_segment(TCPListener &listener, const string &context) {
+    test_err_if(not listener.segments_out().empty(), "unexpected segment " + context);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+
+        // a single handshake: no connection exists until the final ACK
+        {
+            TCPListener listener{cfg};
+            const TCPFourTuple tuple = connection_tuple(5000);
+            const WrappingInt32 peer_isn{static_cast<uint32_t>(rd())};
+
+            listener.segment_received(tuple, make_syn(peer_isn));
+            const WrappingInt32 isn = expect_syn_ack(listener, tuple, peer_isn).header().seqno;
+            test_err_if(listener.syn_backlog_size() != 1, "SYN should be in the backlog");
+            test_err_if(listener.connection_count() != 0, "connection created before the final ACK");
+            test_err_if(listener.accept().has_value(), "accepted a half-open connection");
+
+            listener.segment_received(tuple, make_ack(peer_isn + 1, isn + 1, "hello"));
+            test_err_if(listener.syn_backlog_size() != 0, "backlog entry should be gone");
+            const optional<TCPFourTuple> accepted = listener.accept();
+            test_err_if(accepted != tuple, "connection was not accepted");
+            test_err_if(listener.connection(tuple).state() != TCPState::State::ESTABLISHED, "not established");
+            test_err_if(listener.inbound_stream(tuple).read(5) != "hello", "payload of final ACK was lost");
+
+            const TCPSegment ack = expect_segment(listener, tuple, "ACK of data");
+            test_err_if(ack.header().ackno != peer_isn + 6, "data was not acknowledged");
+
+            listener.write(tuple, "world");
+            const TCPSegment data = expect_segment(listener, tuple, "data");
+            test_err_if(data.payload().copy() != "world" or data.header().seqno != isn + 1, "bad data segment");
+
+            // the connection is only ticked when its retransmission timer is due
+            listener.tick(cfg.rt_timeout - 1);
+            expect_no_segment(listener, "before the retransmission timeout");
+            listener.tick(1);
+            test_err_if(expect_segment(listener, tuple, "retransmission").payload().copy() != "world",
+                        "data was not retransmitted");
+        }
+
+        // many concurrent handshakes, and a retransmitted SYN
+        {
+            TCPListener listener{cfg};
+            vector<pair<WrappingInt32, WrappingInt32>> isns;
+            for (uint16_t port = 1; port <= 50; port++) {
+                const WrappingInt32 peer_isn{static_cast<uint32_t>(rd())};
+                listener.segment_received(connection_tuple(port), make_syn(peer_isn));
+                isns.emplace_back(peer_isn, expect_syn_ack(listener, connection_tuple(port), peer_isn).header().seqno);
+            }
+            listener.segment_received(connection_tuple(7), make_syn(isns[6].first));
+            test_err_if(expect_syn_ack(listener, connection_tuple(7), isns[6].first).header().seqno != isns[6].second,
+                        "retransmitted SYN should get the same SYN/ACK");
+
+            for (uint16_t port = 50; port >= 1; port--) {
+                const auto &[peer_isn, isn] = isns[port - 1];
+                listener.segment_received(connection_tuple(port), make_ack(peer_isn + 1, isn + 1));
+            }
+            expect_no_segment(listener, "after handshakes completed");
+            for (uint16_t port = 50; port >= 1; port--) {
+                test_err_if(listener.accept() != connection_tuple(port), "accept order is wrong");
+            }
+            test_err_if(listener.accept().has_value(), "too many connections accepted");
+        }
+
+        // SYN backlog overflow is answered with SYN cookies, which cost no memory
+        {
+            TCPListenerConfig listener_cfg{};
+            listener_cfg.syn_backlog = 2;
+            TCPListener listener{cfg, listener_cfg};
+            vector<pair<WrappingInt32, WrappingInt32>> isns;
+            for (uint16_t port = 1; port <= 10; port++) {
+                const WrappingInt32 peer_isn{static_cast<uint32_t>(rd())};
+                listener.segment_received(connection_tuple(port), make_syn(peer_isn));
+                isns.emplace_back(peer_isn, expect_syn_ack(listener, connection_tuple(port), peer_isn).header().seqno);
+            }
+            test_err_if(listener.syn_backlog_size() != 2, "SYN backlog exceeded its limit");
+            test_err_if(listener.syn_cookies_sent() != 8, "expected 8 SYN cookies");
+
+            // a forged ACK is refused
+            listener.segment_received(connection_tuple(10), make_ack(isns[9].first + 1, isns[9].second + 2));
+            test_err_if(not expect_segment(listener, connection_tuple(10), "RST").header().rst, "expected RST");
+
+            // cookies are still valid a little while later
+            listener.tick(70 * 1000);
+            while (not listener.segments_out().empty()) {
+                listener.segments_out().pop();  // SYN/ACK retransmissions for the backlog entries
+            }
+            for (uint16_t port = 1; port <= 10; port++) {
+                const auto &[peer_isn, isn] = isns[port - 1];
+                listener.segment_received(connection_tuple(port), make_ack(peer_isn + 1, isn + 1));
+            }
+            expect_no_segment(listener, "after cookie handshakes completed");
+            test_err_if(listener.accept_queue_size() != 10, "cookie handshakes were not accepted");
+
+            // ... but not forever
+            for (uint16_t port = 11; port <= 13; port++) {
+                const WrappingInt32 peer_isn{static_cast<uint32_t>(rd())};
+                listener.segment_received(connection_tuple(port), make_syn(peer_isn));
+                isns.emplace_back(peer_isn, expect_syn_ack(listener, connection_tuple(port), peer_isn).header().seqno);
+            }
+            test_err_if(listener.syn_cookies_sent() != 9, "expected a cookie once the backlog refilled");
+            listener.tick(200 * 1000);
+            while (not listener.segments_out().empty()) {
+                listener.segments_out().pop();
+            }
+            listener.segment_received(connection_tuple(13), make_ack(isns[12].first + 1, isns[12].second + 1));
+            test_err_if(not expect_segment(listener, connection_tuple(13), "RST").header().rst,
+                        "expired cookie accepted");
+        }
+
+        // without SYN cookies, SYNs beyond the backlog are dropped
+        {
+            TCPListenerConfig listener_cfg{};
+            listener_cfg.syn_backlog = 1;
+            listener_cfg.syn_cookies = false;
+            TCPListener listener{cfg, listener_cfg};
+            listener.segment_received(connection_tuple(1), make_syn(WrappingInt32{static_cast<uint32_t>(rd())}));
+            expect_syn_ack(listener, connection_tuple(1), listener.segments_out().front().second.header().ackno - 1);
+            listener.segment_received(connection_tuple(2), make_syn(WrappingInt32{static_cast<uint32_t>(rd())}));
+            expect_no_segment(listener, "for SYN beyond the backlog");
+        }
+
+        // a full accept queue holds back the final ACK until the owner calls accept()
+        {
+            TCPListenerConfig listener_cfg{};
+            listener_cfg.accept_backlog = 1;
+            TCPListener listener{cfg, listener_cfg};
+            vector<pair<WrappingInt32, WrappingInt32>> isns;
+            for (uint16_t port = 1; port <= 2; port++) {
+                const WrappingInt32 peer_isn{static_cast<uint32_t>(rd())};
+                listener.segment_received(connection_tuple(port), make_syn(peer_isn));
+                isns.emplace_back(peer_isn, expect_syn_ack(listener, connection_tuple(port), peer_isn).header().seqno);
+                listener.segment_received(connection_tuple(port), make_ack(peer_isn + 1, isns.back().second + 1));
+            }
+            test_err_if(listener.connection_count() != 1, "accept queue exceeded its limit");
+            test_err_if(listener.syn_backlog_size() != 1, "held-back handshake should stay in the backlog");
+
+            // the SYN/ACK is retransmitted, and the peer's next ACK gets through
+            listener.tick(cfg.rt_timeout);
+            expect_syn_ack(listener, connection_tuple(2), isns[1].first);
+            test_err_if(listener.accept() != connection_tuple(1), "first connection not accepted");
+            listener.segment_received(connection_tuple(2), make_ack(isns[1].first + 1, isns[1].second + 1));
+            test_err_if(listener.accept() != connection_tuple(2), "second connection not accepted");
+        }
+
+        // a connection in TIME_WAIT is collapsed into a record that still answers retransmitted FINs
+        {
+            TCPListener listener{cfg};
+            const TCPFourTuple tuple = connection_tuple(6000);
+
+            // actively close a new connection, returning the peer's FIN
+            const auto close_actively = [&](const WrappingInt32 peer_isn, const WrappingInt32 isn) {
+                listener.segment_received(tuple, make_ack(peer_isn + 1, isn + 1));
+                test_err_if(listener.accept() != tuple, "connection was not accepted");
+                listener.end_input_stream(tuple);
+                test_err_if(not expect_segment(listener, tuple, "FIN").header().fin, "expected FIN");
+
+                TCPSegment fin = make_ack(peer_isn + 1, isn + 2);
+                fin.header().fin = true;
+                listener.segment_received(tuple, fin);
+                const TCPSegment ack = expect_segment(listener, tuple, "ACK of FIN");
+                test_err_if(ack.header().ackno != peer_isn + 2 or ack.header().seqno != isn + 2, "bad ACK of FIN");
+                test_err_if(listener.has_connection(tuple), "connection in TIME_WAIT was not collapsed");
+                test_err_if(listener.time_wait_count() != 1, "expected a TIME_WAIT record");
+                return fin;
+            };
+
+            const WrappingInt32 peer_isn{static_cast<uint32_t>(rd())};
+            listener.segment_received(tuple, make_syn(peer_isn));
+            const WrappingInt32 isn = expect_syn_ack(listener, tuple, peer_isn).header().seqno;
+            const TCPSegment fin = close_actively(peer_isn, isn);
+
+            listener.tick(5 * cfg.rt_timeout);
+            listener.segment_received(tuple, fin);
+            const TCPSegment ack = expect_segment(listener, tuple, "ACK of retransmitted FIN");
+            test_err_if(not ack.header().ack or ack.header().ackno != peer_isn + 2 or ack.header().seqno != isn + 2,
+                        "bad ACK of retransmitted FIN");
+
+            // the retransmitted FIN restarted the timer
+            listener.tick(10 * cfg.rt_timeout - 1);
+            test_err_if(listener.time_wait_count() != 1, "TIME_WAIT ended early");
+            listener.tick(1);
+            test_err_if(listener.time_wait_count() != 0, "TIME_WAIT did not end");
+            expect_no_segment(listener, "after TIME_WAIT");
+
+            // a new SYN from the same peer, with a later sequence number, takes the place of a TIME_WAIT record
+            const WrappingInt32 second_peer_isn = peer_isn + 100;
+            listener.segment_received(tuple, make_syn(second_peer_isn));
+            const WrappingInt32 second_isn = expect_syn_ack(listener, tuple, second_peer_isn).header().seqno;
+            close_actively(second_peer_isn, second_isn);
+            const WrappingInt32 third_peer_isn = second_peer_isn + 100;
+            listener.segment_received(tuple, make_syn(third_peer_isn));
+            expect_syn_ack(listener, tuple, third_peer_isn);
+            test_err_if(listener.time_wait_count() != 0, "TIME_WAIT record was not replaced");
+        }
+
+        // half-open connections are abandoned after too many retransmissions
+        {
+            TCPListener listener{cfg};
+            listener.segment_received(connection_tuple(1), make_syn(WrappingInt32{static_cast<uint32_t>(rd())}));
+            for (unsigned int i = 0; i < 2 * TCPConfig::MAX_RETX_ATTEMPTS; i++) {
+                listener.tick(cfg.rt_timeout << TCPConfig::MAX_RETX_ATTEMPTS);
+            }
+            test_err_if(listener.syn_backlog_size() != 0, "half-open connection never expired");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "tcp_over_ip.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "virtio_net_header.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const string &payload) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.header().ack = true;
+    seg.header().ackno = WrappingInt32{12345};
+    seg.header().win = 1000;
+    seg.payload() = Buffer{string(payload)};
+    return seg;
+}
+
+//! What the device does with a partial checksum: sum from `csum_start` on, and store the result
+static string complete_checksum(string packet, const VirtioNetHeader &vnet) {
+    InternetChecksum check;
+    check.add(string_view{packet}.substr(vnet.csum_start));
+    store_big_endian(packet.data() + vnet.csum_start + vnet.csum_offset, check.value());
+    return packet;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // the virtio-net header survives serialization
+        {
+            VirtioNetHeader vnet;
+            vnet.flags = VirtioNetHeader::FLAG_NEEDS_CSUM;
+            vnet.gso_type = VirtioNetHeader::GSO_TCPV4;
+            vnet.hdr_len = 54;
+            vnet.gso_size = 1448;
+            vnet.csum_start = 34;
+            vnet.csum_offset = 16;
+            const string raw = vnet.serialize();
+            VirtioNetHeader parsed;
+            test_err_if(raw.size() != VirtioNetHeader::LENGTH or parsed.parse(raw) != ParseResult::NoError,
+                        "virtio-net header did not parse");
+            test_err_if(parsed.flags != vnet.flags or parsed.gso_type != vnet.gso_type or
+                            parsed.hdr_len != vnet.hdr_len or parsed.gso_size != vnet.gso_size or
+                            parsed.csum_start != vnet.csum_start or parsed.csum_offset != vnet.csum_offset,
+                        "virtio-net header changed");
+            test_err_if(parsed.parse(raw.substr(0, 9)) == ParseResult::NoError, "short header parsed");
+        }
+
+        // consecutive full-sized segments become one super-packet, which the device can split
+        for (unsigned int round = 0; round < 100; round++) {
+            TCPOverIPv4Adapter adapter;
+            adapter.config_mut().source = {"10.0.0.1", 1234};
+            adapter.config_mut().destination = {"10.0.0.2", 80};
+
+            const WrappingInt32 isn{static_cast<uint32_t>(rd())};
+            const size_t full_segments = 1 + rd() % 20;
+            string data;
+            for (size_t i = 0; i <= full_segments; i++) {
+                const size_t size =
+                    i < full_segments ? TCPConfig::MAX_PAYLOAD_SIZE : 1 + rd() % (TCPConfig::MAX_PAYLOAD_SIZE - 1);
+                string payload(size, 0);
+                for (auto &c : payload) {
+                    c = static_cast<char>(rd());
+                }
+                TCPSegment seg = data_segment(isn + data.size(), payload);
+                seg.header().fin = i == full_segments;
+                data += payload;
+                test_err_if(not adapter.gather_for_offload(seg), "consecutive segment not gathered");
+            }
+            TCPSegment after_fin = data_segment(isn + data.size(), "x");
+            test_err_if(adapter.gather_for_offload(after_fin), "segment gathered after a FIN");
+
+            const auto dgram = adapter.take_offloaded();
+            test_err_if(not dgram.has_value() or adapter.take_offloaded().has_value(), "wrong number of datagrams");
+            const BufferList packet = dgram->serialize();
+            const VirtioNetHeader vnet = VirtioNetHeader::for_packet(packet, 0);
+            test_err_if(vnet.flags != VirtioNetHeader::FLAG_NEEDS_CSUM or vnet.csum_start != IPv4Header::LENGTH or
+                            vnet.csum_offset != 16 or vnet.hdr_len != IPv4Header::LENGTH + TCPHeader::LENGTH,
+                        "wrong checksum offload");
+            const bool super_packet = data.size() > TCPConfig::MAX_PAYLOAD_SIZE;
+            test_err_if(vnet.gso_type != (super_packet ? VirtioNetHeader::GSO_TCPV4 : VirtioNetHeader::GSO_NONE) or
+                            vnet.gso_size != (super_packet ? TCPConfig::MAX_PAYLOAD_SIZE : 0),
+                        "wrong segmentation offload");
+
+            // once the device completes the checksum, the super-packet is a valid segment with all the data
+            InternetDatagram received;
+            test_err_if(received.parse(Buffer{complete_checksum(packet.concatenate(), vnet)}) != ParseResult::NoError,
+                        "super-packet is not a valid datagram");
+            TCPSegment seg;
+            test_err_if(seg.parse(received.payload(), received.header().pseudo_cksum()) != ParseResult::NoError,
+                        "super-packet has a bad checksum");
+            test_err_if(seg.header().seqno != isn or not seg.header().fin or seg.payload().str() != data,
+                        "super-packet lost data");
+        }
+
+        // segments that do not follow on start a new super-packet
+        {
+            TCPOverIPv4Adapter adapter;
+            const string full(TCPConfig::MAX_PAYLOAD_SIZE, 'x');
+            TCPSegment first = data_segment(WrappingInt32{0}, full);
+            TCPSegment gap = data_segment(WrappingInt32{2 * TCPConfig::MAX_PAYLOAD_SIZE}, full);
+            TCPSegment other_ackno = data_segment(WrappingInt32{TCPConfig::MAX_PAYLOAD_SIZE}, full);
+            other_ackno.header().ackno = WrappingInt32{1};
+            TCPSegment syn = data_segment(WrappingInt32{TCPConfig::MAX_PAYLOAD_SIZE}, full);
+            syn.header().syn = true;
+            test_err_if(not adapter.gather_for_offload(first), "first segment not gathered");
+            test_err_if(adapter.gather_for_offload(gap), "segment after a gap gathered");
+            test_err_if(adapter.gather_for_offload(other_ackno), "segment with another ackno gathered");
+            test_err_if(adapter.gather_for_offload(syn), "SYN gathered");
+        }
+
+        // frames other than TCP need no offloads
+        {
+            EthernetFrame frame;
+            frame.header().type = EthernetHeader::TYPE_ARP;
+            ARPMessage arp;
+            arp.opcode = ARPMessage::OPCODE_REQUEST;
+            frame.payload() = arp.serialize();
+            const VirtioNetHeader vnet = VirtioNetHeader::for_packet(frame.serialize(), EthernetHeader::LENGTH);
+            test_err_if(vnet.flags != 0 or vnet.gso_type != VirtioNetHeader::GSO_NONE, "ARP frame has offloads");
+        }
+
+        // a segment whose checksum the kernel vouches for is not checked
+        {
+            TCPSegment seg = data_segment(WrappingInt32{0}, "hello");
+            const string raw = seg.serialize(0).concatenate();
+            TCPSegment parsed;
+            test_err_if(parsed.parse(Buffer{string(raw)}, 1) == ParseResult::NoError, "bad checksum accepted");
+            test_err_if(parsed.parse(Buffer{string(raw)}, 1, false) != ParseResult::NoError,
+                        "unverified segment did not parse");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
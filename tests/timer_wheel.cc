@@ -0,0 +1,99 @@
+#include "test_err_if.hh"
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // timers expire exactly at their deadlines, in order
+        {
+            TimerWheel<int> wheel;
+            wheel.schedule(10, 1);
+            wheel.schedule(5, 2);
+            wheel.schedule(10, 3);
+            test_err_if(not wheel.advance(4).empty(), "timer expired early");
+            test_err_if(wheel.advance(1) != vector<int>{2}, "timer did not expire at its deadline");
+            test_err_if(wheel.advance(100) != (vector<int>{1, 3}), "timers expired out of order");
+            test_err_if(not wheel.empty() or wheel.now() != 105, "wheel is in the wrong state");
+        }
+
+        // cancel and reschedule
+        {
+            TimerWheel<int> wheel;
+            const auto first = wheel.schedule(1000, 1);
+            const auto second = wheel.schedule(5000, 2);
+            wheel.cancel(first);
+            wheel.reschedule(second, 10);
+            test_err_if(wheel.size() != 1, "cancelled timer still counted");
+            test_err_if(wheel.advance(10) != vector<int>{2}, "rescheduled timer did not expire");
+            test_err_if(not wheel.advance(10000).empty(), "cancelled timer expired");
+        }
+
+        // compare against a reference model, across many cascades
+        for (unsigned int round = 0; round < 20; round++) {
+            TimerWheel<unsigned int> wheel;
+            multimap<uint64_t, unsigned int> reference;
+            map<unsigned int, pair<TimerWheel<unsigned int>::Handle, uint64_t>> pending;
+            unsigned int next_id = 0;
+
+            for (unsigned int step = 0; step < 2000; step++) {
+                const unsigned int action = rd() % 8;
+                if (action < 4) {
+                    // delays at every scale, up to about a day
+                    const uint64_t delay = rd() % (uint64_t{1} << (rd() % 27));
+                    const uint64_t deadline = wheel.now() + max(delay, uint64_t{1});
+                    pending.emplace(next_id, make_pair(wheel.schedule(delay, next_id), deadline));
+                    reference.emplace(deadline, next_id);
+                    next_id++;
+                } else if (action == 4 and not pending.empty()) {
+                    auto victim = pending.lower_bound(rd() % next_id);
+                    if (victim == pending.end()) {
+                        victim = pending.begin();
+                    }
+                    wheel.cancel(victim->second.first);
+                    const auto range = reference.equal_range(victim->second.second);
+                    for (auto it = range.first; it != range.second; ++it) {
+                        if (it->second == victim->first) {
+                            reference.erase(it);
+                            break;
+                        }
+                    }
+                    pending.erase(victim);
+                } else {
+                    const uint64_t ms = rd() % (uint64_t{1} << (rd() % 24));
+                    const vector<unsigned int> expired = wheel.advance(ms);
+
+                    vector<uint64_t> expected_deadlines;
+                    for (auto it = reference.begin(); it != reference.end() and it->first <= wheel.now();) {
+                        expected_deadlines.push_back(it->first);
+                        it = reference.erase(it);
+                    }
+                    test_err_if(expired.size() != expected_deadlines.size(),
+                                "expected " + to_string(expected_deadlines.size()) + " timers to expire, got " +
+                                    to_string(expired.size()));
+                    for (size_t i = 0; i < expired.size(); i++) {
+                        test_err_if(pending.at(expired[i]).second != expected_deadlines[i],
+                                    "timer " + to_string(expired[i]) + " expired at the wrong time");
+                        pending.erase(expired[i]);
+                    }
+                }
+                test_err_if(wheel.size() != reference.size(), "wrong number of pending timers");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}